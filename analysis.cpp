@@ -0,0 +1,109 @@
+#include "analysis.h"
+#include "json.h"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+std::string jsonScore(int score, bool isMate) {
+    return "{\"" + std::string(isMate ? "mate" : "cp") + "\":" + std::to_string(score) + "}";
+}
+
+std::string jsonMoves(const std::vector<std::string>& moves) {
+    std::string json = "[";
+    for (size_t i = 0; i < moves.size(); i++) {
+        json += (i ? "," : "") + jsonString(moves[i]);
+    }
+    return json + "]";
+}
+
+} // namespace
+
+SearchResult streamAnalysis(Engine& engine, const std::string& fen, const SearchLimits& limits, std::ostream& out) {
+    ChessBoard board;
+    Color sideToMove;
+    if (!board.setFromFEN(fen, sideToMove)) {
+        out << "{\"type\":\"error\",\"fen\":" << jsonString(fen) << ",\"error\":\"invalid FEN\"}" << std::endl;
+        return SearchResult();
+    }
+
+    // Flushed per line so a reader sees each depth the moment it completes.
+    // UCI engines also send progress without a score or line (currmove, hashfull); those are dropped.
+    engine.setInfoCallback([&out](const SearchInfo& info) {
+        if (!info.hasScore || info.pv.empty()) return;
+        out << "{\"type\":\"info\",\"depth\":" << info.depth << ",\"multipv\":" << info.multipv
+            << ",\"score\":" << jsonScore(info.score, info.isMate) << ",\"nodes\":" << info.nodes
+            << ",\"time\":" << info.timeMs << ",\"pv\":" << jsonMoves(info.pv) << "}" << std::endl;
+    });
+    SearchResult result = engine.search(board, sideToMove, limits);
+    engine.setInfoCallback(nullptr);
+
+    out << "{\"type\":\"bestmove\",\"fen\":" << jsonString(fen) << ",\"bestmove\":" << jsonString(result.bestMove)
+        << ",\"ponder\":" << jsonString(result.ponderMove) << ",\"depth\":" << result.depth
+        << ",\"score\":" << jsonScore(result.score, result.isMate) << ",\"nodes\":" << result.nodes
+        << ",\"pv\":" << jsonMoves(result.pv) << "}" << std::endl;
+    return result;
+}
+
+int runMultiPVCommand(int argc, char* argv[]) {
+    std::string engineSpec = "builtin";
+    std::string fen;
+    SearchLimits limits;
+    limits.multiPV = 3;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--engine" && hasValue) {
+            engineSpec = argv[++i];
+        } else if (arg == "--fen" && hasValue) {
+            fen = argv[++i];
+        } else if (arg == "--multipv" && hasValue) {
+            limits.multiPV = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            limits.nodes = std::atoll(argv[++i]);
+        } else if (arg == "--movetime" && hasValue) {
+            limits.movetimeMs = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown multipv option: " << arg << "\n"
+                      << "Usage: chess multipv [--engine builtin|PATH] [--fen FEN] [--multipv N]\n"
+                      << "       [--depth N] [--nodes N] [--movetime MS]\n"
+                      << "Without --fen, positions are read from standard input, one FEN per line.\n";
+            return 1;
+        }
+    }
+
+    // A bare "go" would let UCI engines search forever
+    if (limits.depth == 0 && limits.nodes == 0 && limits.movetimeMs == 0) {
+        limits.movetimeMs = 1000;
+    }
+    if (limits.multiPV <= 0) {
+        std::cerr << "MultiPV must be positive\n";
+        return 1;
+    }
+
+    std::unique_ptr<Engine> engine = createEngine(engineSpec);
+    if (!engine) {
+        std::cerr << "Failed to start engine: " << engineSpec << "\n";
+        return 1;
+    }
+    engine->newGame();
+
+    if (!fen.empty()) {
+        streamAnalysis(*engine, fen, limits, std::cout);
+        return 0;
+    }
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        streamAnalysis(*engine, line == "startpos" ? START_FEN : line, limits, std::cout);
+    }
+    return 0;
+}
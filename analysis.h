@@ -0,0 +1,16 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "engine.h"
+#include <ostream>
+#include <string>
+
+// Searches one position and writes the engine's progress as JSON lines: an
+// "info" object for every line (multipv) of every depth as soon as the engine
+// reports it, then a final "bestmove" object. Returns the search result.
+SearchResult streamAnalysis(Engine& engine, const std::string& fen, const SearchLimits& limits, std::ostream& out);
+
+// Entry point for "chess multipv [options]"
+int runMultiPVCommand(int argc, char* argv[]);
+
+#endif // ANALYSIS_H
@@ -0,0 +1,346 @@
+#include "analysis_cache.h"
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t RECORD_MAGIC = 0x31524341;   // "ACR1"
+const uint32_t HEADER_MAGIC = 0x31484341;   // "ACH1"
+const size_t HEADER_SIZE = 12;              // Magic and 64-bit generation
+const uint32_t MAX_PAYLOAD = 4096;
+
+void putU16(std::string& out, uint16_t value) {
+    for (int i = 0; i < 2; i++) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+void putU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+uint64_t getLE(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+uint32_t checksum(const char* data, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::string encodeHeader(uint64_t generation) {
+    std::string header;
+    putU32(header, HEADER_MAGIC);
+    putU64(header, generation);
+    return header;
+}
+
+uint64_t newGeneration() {
+    std::random_device device;
+    uint64_t value = (static_cast<uint64_t>(device()) << 32) ^ device();
+    return value ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+long fileSize(FILE* file) {
+    std::fseek(file, 0, SEEK_END);
+    return std::ftell(file);
+}
+
+// Advisory lock on "<log>.lock", held while appending and compacting so that
+// processes sharing the log never write its header twice or compact over each
+// other's records. The lock file is never replaced, unlike the log itself.
+class FileLock {
+public:
+    explicit FileLock(const std::string& logPath) {
+        std::string lockPath = logPath + ".lock";
+#ifdef _WIN32
+        handle = CreateFileA(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        OVERLAPPED overlapped = {};
+        locked = handle != INVALID_HANDLE_VALUE &&
+                 LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+        fd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        locked = fd >= 0 && flock(fd, LOCK_EX) == 0;
+#endif
+        if (!locked) LOG_WARN("Could not lock analysis cache " << lockPath);
+    }
+
+    ~FileLock() {
+#ifdef _WIN32
+        if (locked) {
+            OVERLAPPED overlapped = {};
+            UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+        }
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+        if (locked) flock(fd, LOCK_UN);
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool isLocked() const { return locked; }
+
+private:
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+    bool locked;
+};
+
+} // namespace
+
+const size_t AnalysisCache::DEFAULT_MAX_BYTES;
+const int AnalysisCache::DEFAULT_MIN_DEPTH;
+
+AnalysisCache::AnalysisCache(const std::string& path, size_t maxBytes)
+    : path(path), maxBytes(maxBytes), readOffset(0), generation(0) {}
+
+AnalysisCache& AnalysisCache::shared() {
+    static AnalysisCache cache([] {
+        const char* path = std::getenv("CHESS_ANALYSIS_CACHE");
+        return std::string(path ? path : "analysis.cache");
+    }());
+    return cache;
+}
+
+bool AnalysisCache::lookup(uint64_t key, int minDepth, AnalysisEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh();
+
+    auto it = index.find(key);
+    if (it == index.end() || it->second.depth < minDepth) return false;
+    entry = it->second;
+    return true;
+}
+
+void AnalysisCache::store(uint64_t key, const AnalysisEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string record = encode(key, entry);
+    // Appends without the lock would still be whole records, but the header and
+    // compaction need it, so a failure to lock only costs those
+    FileLock fileLock(path);
+
+    FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        LOG_WARN("Could not open analysis cache " << path);
+        return;
+    }
+    // Unbuffered, so the record reaches the file in one append-mode write
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    if (fileSize(file) == 0) {
+        record = encodeHeader(newGeneration()) + record;
+    }
+    std::fwrite(record.data(), 1, record.size(), file);
+    std::fclose(file);
+
+    refresh();
+    if (static_cast<size_t>(readOffset) > maxBytes && fileLock.isLocked()) {
+        compact();
+    }
+}
+
+size_t AnalysisCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh();
+    return index.size();
+}
+
+void AnalysisCache::refresh() {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return;
+
+    long size = fileSize(file);
+    if (size < static_cast<long>(HEADER_SIZE)) {
+        std::fclose(file);
+        return;
+    }
+
+    // A new generation means the log was compacted (or recreated) by some process
+    char header[HEADER_SIZE];
+    std::fseek(file, 0, SEEK_SET);
+    if (std::fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE ||
+        getLE(header, 4) != HEADER_MAGIC) {
+        std::fclose(file);
+        return;
+    }
+    uint64_t fileGeneration = getLE(header + 4, 8);
+    if (fileGeneration != generation || size < readOffset) {
+        index.clear();
+        generation = fileGeneration;
+        readOffset = HEADER_SIZE;
+    }
+    if (size == readOffset) {
+        std::fclose(file);
+        return;
+    }
+
+    std::vector<char> data(size - readOffset);
+    std::fseek(file, readOffset, SEEK_SET);
+    data.resize(std::fread(data.data(), 1, data.size(), file));
+    std::fclose(file);
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        uint64_t key;
+        AnalysisEntry entry;
+        long length = decode(data, offset, key, entry);
+        if (length == 0) break;         // Another process is still writing this record
+        if (length < 0) {               // Corrupt bytes: resynchronize on the next record
+            offset++;
+            continue;
+        }
+
+        auto it = index.find(key);
+        if (it == index.end() || entry.depth >= it->second.depth) {
+            index[key] = entry;
+        }
+        offset += length;
+    }
+    readOffset += offset;
+}
+
+void AnalysisCache::compact() {
+    // Called with the file lock held, so no record can be appended between this
+    // read of the tail and the rename
+    refresh();
+
+    // Keep the deepest analyses, filling three quarters of the cap to leave room to grow
+    std::vector<std::pair<uint64_t, const AnalysisEntry*>> entries;
+    entries.reserve(index.size());
+    for (const auto& item : index) {
+        entries.emplace_back(item.first, &item.second);
+    }
+    std::sort(entries.begin(), entries.end(), [](const std::pair<uint64_t, const AnalysisEntry*>& a,
+                                                 const std::pair<uint64_t, const AnalysisEntry*>& b) {
+        return a.second->depth > b.second->depth;
+    });
+
+    uint64_t newGen = newGeneration();
+    std::string data = encodeHeader(newGen);
+    std::unordered_map<uint64_t, AnalysisEntry> kept;
+    for (const auto& item : entries) {
+        std::string record = encode(item.first, *item.second);
+        if (data.size() + record.size() > maxBytes * 3 / 4) break;
+        data += record;
+        kept[item.first] = *item.second;
+    }
+
+    std::ostringstream tempPath;
+    tempPath << path << ".compact." << newGen;
+    FILE* file = std::fopen(tempPath.str().c_str(), "wb");
+    if (!file) return;
+    bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = (std::fclose(file) == 0) && written;
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows; MoveFileEx does, without
+    // a moment where the log is missing. It fails while a reader has the log open,
+    // in which case a later store compacts instead.
+    bool renamed = written && MoveFileExA(tempPath.str().c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    bool renamed = written && std::rename(tempPath.str().c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        std::remove(tempPath.str().c_str());
+        return;
+    }
+
+    index.swap(kept);
+    generation = newGen;
+    readOffset = static_cast<long>(data.size());
+}
+
+std::string AnalysisCache::encode(uint64_t key, const AnalysisEntry& entry) {
+    std::string pv;
+    for (const auto& move : entry.pv) {
+        if (pv.size() + move.size() + 1 > 512) break;
+        pv += (pv.empty() ? "" : " ") + move;
+    }
+    std::string bestMove = entry.bestMove.substr(0, 8);
+
+    std::string payload;
+    putU64(payload, key);
+    putU32(payload, static_cast<uint32_t>(entry.score));
+    payload += static_cast<char>(entry.isMate ? 1 : 0);
+    payload += static_cast<char>(std::min(std::max(entry.depth, 0), 255));
+    payload += static_cast<char>(bestMove.size());
+    payload += bestMove;
+    putU16(payload, static_cast<uint16_t>(pv.size()));
+    payload += pv;
+
+    std::string record;
+    putU32(record, RECORD_MAGIC);
+    putU32(record, static_cast<uint32_t>(payload.size()));
+    record += payload;
+    putU32(record, checksum(payload.data(), payload.size()));
+    return record;
+}
+
+long AnalysisCache::decode(const std::vector<char>& data, size_t offset, uint64_t& key, AnalysisEntry& entry) {
+    size_t available = data.size() - offset;
+    const char* p = data.data() + offset;
+    if (available < 8) {
+        // Could be the start of a record still being written, unless the magic is already wrong
+        for (size_t i = 0; i < available && i < 4; i++) {
+            if (static_cast<unsigned char>(p[i]) != ((RECORD_MAGIC >> (8 * i)) & 0xFF)) return -1;
+        }
+        return 0;
+    }
+    if (getLE(p, 4) != RECORD_MAGIC) return -1;
+
+    uint32_t length = static_cast<uint32_t>(getLE(p + 4, 4));
+    if (length < 17 || length > MAX_PAYLOAD) return -1;
+    if (available < 8 + length + 4) return 0;
+
+    const char* payload = p + 8;
+    if (getLE(payload + length, 4) != checksum(payload, length)) return -1;
+
+    key = getLE(payload, 8);
+    entry.score = static_cast<int32_t>(getLE(payload + 8, 4));
+    entry.isMate = payload[12] != 0;
+    entry.depth = static_cast<unsigned char>(payload[13]);
+    size_t moveLength = static_cast<unsigned char>(payload[14]);
+    if (15 + moveLength + 2 > length) return -1;
+    entry.bestMove.assign(payload + 15, moveLength);
+    size_t pvLength = getLE(payload + 15 + moveLength, 2);
+    if (15 + moveLength + 2 + pvLength != length) return -1;
+
+    std::istringstream pv(std::string(payload + 17 + moveLength, pvLength));
+    std::string move;
+    entry.pv.clear();
+    while (pv >> move) entry.pv.push_back(move);
+
+    return static_cast<long>(8 + length + 4);
+}
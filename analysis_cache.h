@@ -0,0 +1,60 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AnalysisEntry {
+    std::string bestMove;
+    int score = 0;
+    bool isMate = false;
+    int depth = 0;
+    std::vector<std::string> pv;
+};
+
+// Engine analysis keyed by ChessBoard::getHash, stored in an append-only log.
+//
+// Every process appends complete, checksummed records with a single write and
+// follows the tail of the log on lookup, so results written by one process are
+// seen by all others on the host. Appends and compaction hold an advisory lock
+// on "<path>.lock"; lookups take no lock. The in-memory index keeps the deepest
+// entry per position. When the log grows past maxBytes it is rewritten with the
+// deepest entries only (shallow analyses are the cheapest to recompute) and
+// atomically renamed over the old one; readers notice and reload.
+class AnalysisCache {
+public:
+    static const size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+    // Depth a cached entry needs to answer a search that only has a time or node limit
+    static const int DEFAULT_MIN_DEPTH = 16;
+
+    explicit AnalysisCache(const std::string& path, size_t maxBytes = DEFAULT_MAX_BYTES);
+
+    // Finds an entry searched to at least minDepth
+    bool lookup(uint64_t key, int minDepth, AnalysisEntry& entry);
+    void store(uint64_t key, const AnalysisEntry& entry);
+    size_t size();
+
+    // Process-wide cache at $CHESS_ANALYSIS_CACHE, or "analysis.cache" by default
+    static AnalysisCache& shared();
+
+private:
+    void refresh();
+    // Needs the file lock; reads the tail itself before rewriting the log
+    void compact();
+    static std::string encode(uint64_t key, const AnalysisEntry& entry);
+    // Returns the record length, 0 if the record is incomplete, or -1 if the data is corrupt
+    static long decode(const std::vector<char>& data, size_t offset, uint64_t& key, AnalysisEntry& entry);
+
+    std::string path;
+    size_t maxBytes;
+    long readOffset;
+    uint64_t generation;
+    std::unordered_map<uint64_t, AnalysisEntry> index;
+    std::mutex mutex;
+};
+
+#endif // ANALYSIS_CACHE_H
@@ -0,0 +1,433 @@
+// Micro-benchmarks for the board primitives on the move generation hot path.
+//
+// Every benchmark runs over a fixed set of positions, is warmed up, then timed
+// for a number of repetitions. The report is JSON with one benchmark per line,
+// so two runs (e.g. before and after a change) can be compared with --baseline.
+
+#include "chess.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct PositionClass {
+    const char* name;
+    std::vector<const char*> fens;
+};
+
+// Changing these positions makes results incomparable with earlier runs
+const std::vector<PositionClass> POSITION_CLASSES = {
+    {"opening", {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    }},
+    {"middlegame", {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "2r3k1/pp3ppp/2n1b3/3pP3/3P4/P1N2N2/1P3PPP/R5K1 b - - 0 20",
+    }},
+    {"endgame", {
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "8/8/4k3/8/2K5/8/3P4/8 w - - 0 1",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    }},
+    {"check", {
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbqk1nr/pppp1ppp/8/4p3/1b1P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 3",
+        "4k3/8/8/8/8/8/4r3/4K3 w - - 0 1",
+    }},
+};
+
+struct BenchPosition {
+    std::string className;
+    ChessBoard board;
+    Color sideToMove;
+    std::vector<Move> legalMoves;
+};
+
+struct BenchConfig {
+    int warmup = 20;
+    int repetitions = 200;
+    std::string filter;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string positionClass;
+    long long opsPerRepetition = 0;
+    double medianNs = 0.0;      // Per operation
+    double p99Ns = 0.0;
+    double minNs = 0.0;
+    double meanNs = 0.0;
+};
+
+// Stops the compiler from discarding the work being measured
+volatile long long sink = 0;
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// One repetition returns the nanoseconds spent in the timed part, so it can do
+// untimed setup (such as copying boards for movePiece) of its own
+typedef std::function<long long()> Repetition;
+
+template <typename Fn>
+long long timeNs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchConfig& config) : config(config) {}
+
+    void run(const std::string& name, const std::string& positionClass, long long opsPerRepetition,
+             const Repetition& repetition) {
+        std::string id = name + "/" + positionClass;
+        if (!config.filter.empty() && id.find(config.filter) == std::string::npos) return;
+        if (opsPerRepetition <= 0) return;
+
+        for (int i = 0; i < config.warmup; i++) repetition();
+
+        std::vector<double> samples;
+        samples.reserve(config.repetitions);
+        for (int i = 0; i < config.repetitions; i++) {
+            samples.push_back(static_cast<double>(repetition()) / opsPerRepetition);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult result;
+        result.name = name;
+        result.positionClass = positionClass;
+        result.opsPerRepetition = opsPerRepetition;
+        result.medianNs = percentile(samples, 0.5);
+        result.p99Ns = percentile(samples, 0.99);
+        result.minNs = samples.front();
+        double total = 0.0;
+        for (double sample : samples) total += sample;
+        result.meanNs = total / samples.size();
+        results.push_back(result);
+
+        std::cerr << std::left << std::setw(32) << id << std::right << std::fixed << std::setprecision(1)
+                  << " median " << std::setw(10) << result.medianNs << " ns"
+                  << "   p99 " << std::setw(10) << result.p99Ns << " ns\n";
+    }
+
+    const std::vector<BenchResult>& getResults() const { return results; }
+
+private:
+    BenchConfig config;
+    std::vector<BenchResult> results;
+};
+
+void writeJSON(std::ostream& out, const BenchConfig& config, const std::vector<BenchResult>& results) {
+    out << std::fixed << std::setprecision(1);
+    out << "{\n";
+    out << "\"schema\": 1,\n";
+    out << "\"warmup\": " << config.warmup << ",\n";
+    out << "\"repetitions\": " << config.repetitions << ",\n";
+    out << "\"unit\": \"ns/op\",\n";
+    out << "\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "{\"name\": \"" << r.name << "\", \"class\": \"" << r.positionClass
+            << "\", \"ops\": " << r.opsPerRepetition
+            << ", \"median\": " << r.medianNs << ", \"p99\": " << r.p99Ns
+            << ", \"min\": " << r.minNs << ", \"mean\": " << r.meanNs << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n}\n";
+}
+
+// Reads the medians of a report written by writeJSON, keyed by "name/class"
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> medians;
+    std::ifstream file(path);
+    std::string line;
+    auto field = [](const std::string& text, const std::string& key) {
+        size_t start = text.find("\"" + key + "\": ");
+        if (start == std::string::npos) return std::string();
+        start += key.length() + 4;
+        if (text[start] == '"') {
+            start++;
+            return text.substr(start, text.find('"', start) - start);
+        }
+        return text.substr(start, text.find_first_of(",}", start) - start);
+    };
+    while (std::getline(file, line)) {
+        std::string name = field(line, "name");
+        std::string median = field(line, "median");
+        if (name.empty() || median.empty()) continue;
+        medians[name + "/" + field(line, "class")] = std::atof(median.c_str());
+    }
+    return medians;
+}
+
+// Prints the change against the baseline; returns false if any median regressed past the threshold
+bool compareWithBaseline(const std::map<std::string, double>& baseline, const std::vector<BenchResult>& results,
+                         double thresholdPercent) {
+    bool ok = true;
+    std::cerr << "\nChange in median against baseline (threshold " << thresholdPercent << "%):\n";
+    for (const auto& r : results) {
+        std::string id = r.name + "/" + r.positionClass;
+        auto it = baseline.find(id);
+        if (it == baseline.end() || it->second <= 0.0) continue;
+
+        double change = (r.medianNs / it->second - 1.0) * 100.0;
+        bool regressed = change > thresholdPercent;
+        ok = ok && !regressed;
+        std::cerr << std::left << std::setw(32) << id << std::right << std::showpos << std::setprecision(1)
+                  << std::setw(8) << change << "%" << std::noshowpos << (regressed ? "   REGRESSION" : "") << "\n";
+    }
+    return ok;
+}
+
+std::vector<BenchPosition> loadPositions() {
+    std::vector<BenchPosition> positions;
+    for (const auto& positionClass : POSITION_CLASSES) {
+        for (const char* fen : positionClass.fens) {
+            BenchPosition position;
+            position.className = positionClass.name;
+            if (!position.board.setFromFEN(fen, position.sideToMove)) {
+                std::cerr << "Invalid benchmark FEN: " << fen << "\n";
+                std::exit(1);
+            }
+            position.legalMoves = position.board.getAllLegalMoves(position.sideToMove);
+            positions.push_back(position);
+        }
+    }
+    return positions;
+}
+
+void runBenchmarks(BenchRunner& runner, const std::vector<BenchPosition>& positions) {
+    const int batch = 10;   // Passes over the position set per repetition, to dwarf the timer overhead
+
+    // Move generation, per position class
+    for (const auto& positionClass : POSITION_CLASSES) {
+        std::vector<const BenchPosition*> subset;
+        for (const auto& position : positions) {
+            if (position.className == positionClass.name) subset.push_back(&position);
+        }
+        runner.run("getAllLegalMoves", positionClass.name, batch * static_cast<long long>(subset.size()), [&] {
+            return timeNs([&] {
+                for (int i = 0; i < batch; i++) {
+                    for (const BenchPosition* position : subset) {
+                        sink += position->board.getAllLegalMoves(position->sideToMove).size();
+                    }
+                }
+            });
+        });
+    }
+
+    long long moveCount = 0;
+    for (const auto& position : positions) moveCount += position.legalMoves.size();
+    long long positionCount = static_cast<long long>(positions.size());
+
+    runner.run("isSquareAttacked", "all", batch * positionCount * 64, [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& position : positions) {
+                    Color attacker = opposite(position.sideToMove);
+                    for (int row = 0; row < 8; row++) {
+                        for (int col = 0; col < 8; col++) {
+                            sink += position.board.isSquareAttacked(Position(row, col), attacker, false);
+                        }
+                    }
+                }
+            }
+        });
+    });
+
+    runner.run("isInCheck", "all", batch * positionCount, [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& position : positions) {
+                    sink += position.board.isInCheck(position.sideToMove);
+                }
+            }
+        });
+    });
+
+    runner.run("wouldBeInCheck", "all", moveCount, [&] {
+        return timeNs([&] {
+            for (const auto& position : positions) {
+                for (const Move& move : position.legalMoves) {
+                    sink += position.board.wouldBeInCheck(move, position.sideToMove);
+                }
+            }
+        });
+    });
+
+    runner.run("isLegal", "all", moveCount, [&] {
+        return timeNs([&] {
+            for (const auto& position : positions) {
+                for (const Move& move : position.legalMoves) {
+                    sink += position.board.isLegal(move);
+                }
+            }
+        });
+    });
+
+    std::vector<std::pair<const ChessBoard*, Move>> captures;
+    for (const auto& position : positions) {
+        for (const Move& move : position.legalMoves) {
+            if (position.board.getPiece(move.to)) captures.emplace_back(&position.board, move);
+        }
+    }
+    runner.run("staticExchange", "all", batch * static_cast<long long>(captures.size()), [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& capture : captures) {
+                    sink += capture.first->staticExchange(capture.second);
+                }
+            }
+        });
+    });
+
+    runner.run("copyConstructor", "all", batch * positionCount, [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& position : positions) {
+                    ChessBoard copy(position.board);
+                    sink += copy.getHalfmoveClock();
+                }
+            }
+        });
+    });
+
+    ChessBoard target;
+    runner.run("copyFrom", "all", batch * positionCount, [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& position : positions) {
+                    target.copyFrom(position.board);
+                    sink += target.getHalfmoveClock();
+                }
+            }
+        });
+    });
+
+    // Every legal move is played on its own fresh copy; copying is not timed
+    std::vector<ChessBoard> boards(static_cast<size_t>(moveCount));
+    runner.run("movePiece", "all", moveCount, [&] {
+        size_t index = 0;
+        for (const auto& position : positions) {
+            for (size_t i = 0; i < position.legalMoves.size(); i++) boards[index++].copyFrom(position.board);
+        }
+        return timeNs([&] {
+            size_t next = 0;
+            for (const auto& position : positions) {
+                for (const Move& move : position.legalMoves) {
+                    sink += boards[next++].movePiece(move);
+                }
+            }
+        });
+    });
+
+    runner.run("getFEN", "all", batch * positionCount, [&] {
+        return timeNs([&] {
+            for (int i = 0; i < batch; i++) {
+                for (const auto& position : positions) {
+                    sink += position.board.getFEN(position.sideToMove).size();
+                }
+            }
+        });
+    });
+
+    // Both spellings the game accepts, for every legal move
+    std::vector<std::string> notations;
+    for (const auto& position : positions) {
+        for (const Move& move : position.legalMoves) {
+            std::string uci = position.board.getUCI(move);
+            notations.push_back(uci);
+            notations.push_back(uci.substr(0, 2) + "-" + uci.substr(2));
+        }
+    }
+    ChessGame game(false);
+    runner.run("parseAlgebraicNotation", "all", static_cast<long long>(notations.size()), [&] {
+        return timeNs([&] {
+            for (const std::string& notation : notations) {
+                sink += game.parseAlgebraicNotation(notation).to.col;
+            }
+        });
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    std::string outputFile;
+    std::string baselineFile;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--warmup" && hasValue) {
+            config.warmup = std::atoi(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            config.repetitions = std::atoi(argv[++i]);
+        } else if (arg == "--filter" && hasValue) {
+            config.filter = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            outputFile = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselineFile = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n"
+                      << "Usage: chess_bench [--warmup N] [--repetitions N] [--filter TEXT]\n"
+                      << "       [--output FILE] [--baseline FILE] [--threshold PERCENT]\n";
+            return 1;
+        }
+    }
+    if (config.warmup < 0 || config.repetitions <= 0) {
+        std::cerr << "Repetitions must be positive\n";
+        return 1;
+    }
+
+    // Read the baseline first, so it can be the same file as the output
+    std::map<std::string, double> baseline;
+    if (!baselineFile.empty()) {
+        baseline = readBaseline(baselineFile);
+        if (baseline.empty()) {
+            std::cerr << "No benchmark results in " << baselineFile << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<BenchPosition> positions = loadPositions();
+    BenchRunner runner(config);
+    runBenchmarks(runner, positions);
+
+    if (outputFile.empty()) {
+        writeJSON(std::cout, config, runner.getResults());
+    } else {
+        std::ofstream out(outputFile);
+        if (!out) {
+            std::cerr << "Could not open " << outputFile << "\n";
+            return 1;
+        }
+        writeJSON(out, config, runner.getResults());
+    }
+
+    if (!baseline.empty() && !compareWithBaseline(baseline, runner.getResults(), threshold)) {
+        return 2;
+    }
+    return 0;
+}
@@ -1,8 +1,12 @@
 #include "chess.h"
+#include "profiler.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 
-ChessBoard::ChessBoard() : enPassantAvailable(false) {
+ChessBoard::ChessBoard() : enPassantAvailable(false), halfmoveClock(0), fullmoveNumber(1) {
     // Initialize empty board
     for (int row = 0; row < 8; row++) {
         for (int col = 0; col < 8; col++) {
@@ -12,7 +16,7 @@ ChessBoard::ChessBoard() : enPassantAvailable(false) {
     setupInitialPosition();
 }
 
-ChessBoard::ChessBoard(const ChessBoard& other) : enPassantAvailable(false) {
+ChessBoard::ChessBoard(const ChessBoard& other) : enPassantAvailable(false), halfmoveClock(0), fullmoveNumber(1) {
     copyFrom(other);
 }
 
@@ -24,6 +28,7 @@ ChessBoard& ChessBoard::operator=(const ChessBoard& other) {
 }
 
 void ChessBoard::copyFrom(const ChessBoard& other) {
+    PROFILE_SCOPE(COPY_FROM);
     // Copy board state
     for (int row = 0; row < 8; row++) {
         for (int col = 0; col < 8; col++) {
@@ -38,6 +43,11 @@ void ChessBoard::copyFrom(const ChessBoard& other) {
     // Copy en passant state
     enPassantTarget = other.enPassantTarget;
     enPassantAvailable = other.enPassantAvailable;
+    halfmoveClock = other.halfmoveClock;
+    fullmoveNumber = other.fullmoveNumber;
+    kingSquares[0] = other.kingSquares[0];
+    kingSquares[1] = other.kingSquares[1];
+    std::memcpy(attackCounts, other.attackCounts, sizeof(attackCounts));
 }
 
 void ChessBoard::setupInitialPosition() {
@@ -77,6 +87,9 @@ void ChessBoard::setupInitialPosition() {
     board[7][7] = std::make_unique<Rook>(Color::BLACK);
 
     enPassantAvailable = false;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    rebuildAttackMaps();
 }
 
 void ChessBoard::displayBoard() const {
@@ -97,6 +110,85 @@ void ChessBoard::displayBoard() const {
     std::cout << "    a   b   c   d   e   f   g   h\n\n";
 }
 
+namespace {
+
+const int rayDirections[8][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+const int knightOffsets[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+
+inline bool onBoard(int row, int col) {
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+// Index of the lowest set bit, which is then cleared
+inline int popSquare(uint64_t& bits) {
+#if defined(__GNUC__)
+    int square = __builtin_ctzll(bits);
+#else
+    int square = 0;
+    while (!(bits & (uint64_t(1) << square))) square++;
+#endif
+    bits &= bits - 1;
+    return square;
+}
+
+// Whether a piece of this type attacks along ray direction d (straight for d < 4)
+inline bool slidesAlong(PieceType type, int d) {
+    return type == PieceType::QUEEN || type == (d < 4 ? PieceType::ROOK : PieceType::BISHOP);
+}
+
+} // namespace
+
+void ChessBoard::updateAttacks(int square, int delta) {
+    int row = square / 8;
+    int col = square % 8;
+    Piece* piece = board[row][col].get();
+    if (!piece) return;
+    uint8_t* counts = attackCounts[static_cast<int>(piece->color)];
+    auto touch = [&](int r, int c) {
+        if (onBoard(r, c)) counts[r * 8 + c] = static_cast<uint8_t>(counts[r * 8 + c] + delta);
+    };
+
+    switch (piece->type) {
+        case PieceType::PAWN: {
+            int direction = (piece->color == Color::WHITE) ? 1 : -1;
+            touch(row + direction, col - 1);
+            touch(row + direction, col + 1);
+            break;
+        }
+        case PieceType::KNIGHT:
+            for (const auto& offset : knightOffsets) touch(row + offset[0], col + offset[1]);
+            break;
+        case PieceType::KING:
+            for (const auto& dir : rayDirections) touch(row + dir[0], col + dir[1]);
+            break;
+        default:
+            // Sliders attack up to and including the first occupied square of each ray
+            for (int d = 0; d < 8; d++) {
+                if (!slidesAlong(piece->type, d)) continue;
+                int r = row + rayDirections[d][0];
+                int c = col + rayDirections[d][1];
+                while (onBoard(r, c)) {
+                    touch(r, c);
+                    if (board[r][c]) break;
+                    r += rayDirections[d][0];
+                    c += rayDirections[d][1];
+                }
+            }
+            break;
+    }
+}
+
+void ChessBoard::rebuildAttackMaps() {
+    std::memset(attackCounts, 0, sizeof(attackCounts));
+    kingSquares[0] = kingSquares[1] = Position(-1, -1);
+    for (int square = 0; square < 64; square++) {
+        Piece* piece = board[square / 8][square % 8].get();
+        if (!piece) continue;
+        if (piece->type == PieceType::KING) kingSquares[static_cast<int>(piece->color)] = Position(square / 8, square % 8);
+        updateAttacks(square, 1);
+    }
+}
+
 Piece* ChessBoard::getPiece(const Position& pos) const {
     if (!pos.isValid()) return nullptr;
     return board[pos.row][pos.col].get();
@@ -113,6 +205,10 @@ bool ChessBoard::movePiece(const Move& move) {
     Piece* piece = getPiece(move.from);
     if (!piece) return false;
 
+    // Promotion replaces the moving piece, so keep what we need from it
+    PieceType movedType = piece->type;
+    Color movedColor = piece->color;
+
     // Clear en passant flag at the start of each move
     bool wasEnPassant = enPassantAvailable;
     Position oldEnPassantTarget = enPassantTarget;
@@ -140,6 +236,37 @@ bool ChessBoard::movePiece(const Move& move) {
         isPromotion = true;
     }
 
+    // Squares whose contents change
+    uint64_t changed = (uint64_t(1) << (move.from.row * 8 + move.from.col)) |
+                       (uint64_t(1) << (move.to.row * 8 + move.to.col));
+    if (isEnPassantCapture) {
+        int capturedPawnRow = (movedColor == Color::WHITE) ? move.to.row - 1 : move.to.row + 1;
+        changed |= uint64_t(1) << (capturedPawnRow * 8 + move.to.col);
+    }
+    if (isCastling) {
+        changed |= uint64_t(1) << (move.from.row * 8 + ((move.to.col > move.from.col) ? 7 : 0));
+        changed |= uint64_t(1) << (move.from.row * 8 + ((move.to.col > move.from.col) ? 5 : 3));
+    }
+
+    // Only the pieces on those squares and the sliders whose rays reach them attack
+    // differently afterwards. Looking through the changed squares finds the same
+    // sliders before and after the move, so their old attacks can be taken off
+    // now and the new ones added once the board is updated.
+    uint64_t affected = changed;
+    for (uint64_t bits = changed; bits;) {
+        int square = popSquare(bits);
+        for (int d = 0; d < 8; d++) {
+            int r = square / 8 + rayDirections[d][0];
+            int c = square % 8 + rayDirections[d][1];
+            while (onBoard(r, c) && (!board[r][c] || (changed & (uint64_t(1) << (r * 8 + c))))) {
+                r += rayDirections[d][0];
+                c += rayDirections[d][1];
+            }
+            if (onBoard(r, c) && slidesAlong(board[r][c]->type, d)) affected |= uint64_t(1) << (r * 8 + c);
+        }
+    }
+    for (uint64_t bits = affected; bits;) updateAttacks(popSquare(bits), -1);
+
     // Perform the move
     std::unique_ptr<Piece> capturedPiece = std::move(board[move.to.row][move.to.col]);
     board[move.to.row][move.to.col] = std::move(board[move.from.row][move.from.col]);
@@ -150,7 +277,7 @@ bool ChessBoard::movePiece(const Move& move) {
     // Handle special move cases
     if (isEnPassantCapture) {
         // Remove the captured pawn
-        int capturedPawnRow = (piece->color == Color::WHITE) ? move.to.row - 1 : move.to.row + 1;
+        int capturedPawnRow = (movedColor == Color::WHITE) ? move.to.row - 1 : move.to.row + 1;
         board[capturedPawnRow][move.to.col] = nullptr;
     }
 
@@ -186,77 +313,43 @@ bool ChessBoard::movePiece(const Move& move) {
         board[move.to.row][move.to.col]->hasMoved = true;
     }
 
+    for (uint64_t bits = affected; bits;) updateAttacks(popSquare(bits), 1);
+    if (movedType == PieceType::KING) kingSquares[static_cast<int>(movedColor)] = move.to;
+    if (capturedPiece && capturedPiece->type == PieceType::KING) {
+        kingSquares[static_cast<int>(capturedPiece->color)] = Position(-1, -1);
+    }
+
     // Set en passant target if pawn moved two squares
-    if (piece->type == PieceType::PAWN && abs(move.to.row - move.from.row) == 2) {
+    if (movedType == PieceType::PAWN && abs(move.to.row - move.from.row) == 2) {
         int enPassantRow = (move.from.row + move.to.row) / 2;
         setEnPassant(Position(enPassantRow, move.from.col));
     }
 
+    // Update move counters
+    if (movedType == PieceType::PAWN || capturedPiece || isEnPassantCapture) {
+        halfmoveClock = 0;
+    } else {
+        halfmoveClock++;
+    }
+    if (movedColor == Color::BLACK) {
+        fullmoveNumber++;
+    }
+
     return true;
 }
 
 bool ChessBoard::isSquareAttacked(const Position& pos, Color attackingColor, bool castling_check = false) const {
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            Piece* piece = board[row][col].get();
-            if (piece && piece->color == attackingColor) {
-                Position piecePos(row, col);
-
-                // For pawns, check diagonal attacks specifically
-                if (piece->type == PieceType::PAWN) {
-                    int direction = (attackingColor == Color::WHITE) ? 1 : -1;
-                    Position leftAttack(row + direction, col - 1);
-                    Position rightAttack(row + direction, col + 1);
-
-                    if (leftAttack == pos || rightAttack == pos) {
-                        return true;
-                    }
-                } else if (castling_check && piece->type == PieceType::KING) {
-                    // For king, check if the square is attacked by any piece
-                    // King can only move one square, so we check all adjacent squares
-                    int directions[8][2] = {
-                        {0, 1}, {0, -1}, {1, 0}, {-1, 0},
-                        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-                    };
-
-                    for (const auto& dir : directions) {
-                        Position adjacentPos(piecePos.row + dir[0], piecePos.col + dir[1]);
-                        if (adjacentPos == pos) {
-                            return true;
-                        }
-                    }
-                } else if (piece->type == PieceType::KING && !castling_check)
-                {
-                    /* code */
-                } else {
-                    // For other pieces, get their possible moves
-                    // We need to be careful not to cause infinite recursion
-                    // Create a temporary non-const reference
-                    ChessBoard* nonConstThis = const_cast<ChessBoard*>(this);
-                    auto moves = piece->getPossibleMoves(piecePos, *nonConstThis);
-
-                    for (const auto& move : moves) {
-                        if (move.to == pos) {
-                            return true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return false;
-}
-
-Position ChessBoard::getKingPosition(Color color) const {
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            Piece* piece = board[row][col].get();
-            if (piece && piece->type == PieceType::KING && piece->color == color) {
-                return Position(row, col);
-            }
+    PROFILE_SCOPE(IS_SQUARE_ATTACKED);
+    if (!pos.isValid()) return false;
+    int attackers = attackCount(pos, attackingColor);
+    if (!castling_check && attackers > 0) {
+        // Leave out the king's own attack
+        Position king = getKingPosition(attackingColor);
+        if (king.isValid() && !(king == pos) && std::abs(king.row - pos.row) <= 1 && std::abs(king.col - pos.col) <= 1) {
+            attackers--;
         }
     }
-    return Position(-1, -1);  // King not found (shouldn't happen)
+    return attackers > 0;
 }
 
 bool ChessBoard::isInCheck(Color kingColor) const {
@@ -264,10 +357,11 @@ bool ChessBoard::isInCheck(Color kingColor) const {
     if (!kingPos.isValid()) return false;
 
     Color enemyColor = (kingColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
-    return isSquareAttacked(kingPos, enemyColor);
+    return attackCount(kingPos, enemyColor) > 0;
 }
 
 bool ChessBoard::wouldBeInCheck(const Move& move, Color kingColor) const {
+    PROFILE_SCOPE(WOULD_BE_IN_CHECK);
     // Create a copy of the board to test the move
     ChessBoard tempBoard = *this;
 
@@ -278,6 +372,7 @@ bool ChessBoard::wouldBeInCheck(const Move& move, Color kingColor) const {
     return tempBoard.isInCheck(kingColor);
 }
 std::vector<Move> ChessBoard::getAllLegalMoves(Color color) const {
+    PROFILE_SCOPE(GET_ALL_LEGAL_MOVES);
     std::vector<Move> legalMoves;
 
     for (int row = 0; row <8; row++) { 
@@ -286,14 +381,12 @@ std::vector<Move> ChessBoard::getAllLegalMoves(Color color) const {
             if (piece && piece->color == color) {
                 Position piecePos(row, col);
                 ChessBoard* nonConstThis = const_cast<ChessBoard*>(this);
-                // std::cout << "Here"<<row<<col<<"\n";
                 auto possibleMoves = piece->getPossibleMoves(piecePos, *nonConstThis);
                 for (const auto& move : possibleMoves) {
                     if (!wouldBeInCheck(move, color)) {
                         legalMoves.push_back(move);
                     }
                 }
-                // std::cout << "Here3\n";
             }
         }
     }
@@ -335,12 +428,552 @@ std::string ChessBoard::getFEN(Color currentPlayer) const {
     fen += " ";
     fen += (currentPlayer == Color::WHITE) ? "w" : "b";
 
-    // Simplify: no castling, en passant, halfmove clock, fullmove number
-    fen += " - - 0 1";
+    // Castling rights, derived from king and rook move flags
+    std::string castling;
+    if (canStillCastle(Color::WHITE, true)) castling += "K";
+    if (canStillCastle(Color::WHITE, false)) castling += "Q";
+    if (canStillCastle(Color::BLACK, true)) castling += "k";
+    if (canStillCastle(Color::BLACK, false)) castling += "q";
+    fen += " " + (castling.empty() ? std::string("-") : castling);
+
+    // En passant target
+    fen += " " + (enPassantAvailable ? enPassantTarget.toAlgebraic() : std::string("-"));
+
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
 
     return fen;
 }
 
+bool ChessBoard::setFromFEN(const std::string& fen, Color& sideToMove) {
+    std::istringstream iss(fen);
+    std::string placement, side, castling = "-", enPassant = "-";
+    int halfmove = 0, fullmove = 1;
+    if (!(iss >> placement >> side)) return false;
+    iss >> castling >> enPassant >> halfmove >> fullmove;
+
+    std::unique_ptr<Piece> newBoard[8][8];
+    int row = 7, col = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (col != 8 || row == 0) return false;
+            row--;
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+            if (col > 8) return false;
+        } else {
+            if (col >= 8) return false;
+            Color color = std::isupper(static_cast<unsigned char>(c)) ? Color::WHITE : Color::BLACK;
+            switch (std::tolower(static_cast<unsigned char>(c))) {
+                case 'p': newBoard[row][col] = std::make_unique<Pawn>(color); break;
+                case 'r': newBoard[row][col] = std::make_unique<Rook>(color); break;
+                case 'n': newBoard[row][col] = std::make_unique<Knight>(color); break;
+                case 'b': newBoard[row][col] = std::make_unique<Bishop>(color); break;
+                case 'q': newBoard[row][col] = std::make_unique<Queen>(color); break;
+                case 'k': newBoard[row][col] = std::make_unique<King>(color); break;
+                default: return false;
+            }
+            // Kings and rooks regain their castling rights below
+            PieceType type = newBoard[row][col]->type;
+            newBoard[row][col]->hasMoved = (type == PieceType::KING || type == PieceType::ROOK);
+            col++;
+        }
+    }
+    if (row != 0 || col != 8) return false;
+    if (side != "w" && side != "b") return false;
+
+    // Castling rights: clear the moved flag on the king and the matching rook
+    auto grantCastling = [&newBoard](int rankRow, int rookCol, Color color) {
+        Piece* king = newBoard[rankRow][4].get();
+        Piece* rook = newBoard[rankRow][rookCol].get();
+        if (king && king->type == PieceType::KING && king->color == color &&
+            rook && rook->type == PieceType::ROOK && rook->color == color) {
+            king->hasMoved = false;
+            rook->hasMoved = false;
+        }
+    };
+    for (char c : castling) {
+        switch (c) {
+            case 'K': grantCastling(0, 7, Color::WHITE); break;
+            case 'Q': grantCastling(0, 0, Color::WHITE); break;
+            case 'k': grantCastling(7, 7, Color::BLACK); break;
+            case 'q': grantCastling(7, 0, Color::BLACK); break;
+            default: break;
+        }
+    }
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            board[r][c] = std::move(newBoard[r][c]);
+        }
+    }
+    rebuildAttackMaps();
+
+    Position epPos = Position::fromAlgebraic(enPassant);
+    if (epPos.isValid()) {
+        setEnPassant(epPos);
+    } else {
+        clearEnPassant();
+    }
+    halfmoveClock = halfmove;
+    fullmoveNumber = fullmove;
+    sideToMove = (side == "w") ? Color::WHITE : Color::BLACK;
+    return true;
+}
+
+std::string ChessBoard::getPositionKey(Color currentPlayer) const {
+    std::string fen = getFEN(currentPlayer);
+    // Drop the halfmove clock and fullmove number
+    size_t end = fen.find_last_of(' ');
+    end = fen.find_last_of(' ', end - 1);
+    return fen.substr(0, end);
+}
+
+namespace {
+
+struct ZobristKeys {
+    uint64_t pieces[2][6][64];
+    uint64_t blackToMove;
+    uint64_t castling[4];
+    uint64_t enPassantFile[8];
+
+    ZobristKeys() {
+        // Fixed seed so hashes are stable across runs and processes
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        auto next = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        };
+        for (auto& color : pieces) {
+            for (auto& type : color) {
+                for (auto& square : type) square = next();
+            }
+        }
+        blackToMove = next();
+        for (auto& key : castling) key = next();
+        for (auto& key : enPassantFile) key = next();
+    }
+};
+
+const ZobristKeys& zobrist() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+} // namespace
+
+uint64_t ChessBoard::getHash(Color currentPlayer) const {
+    const ZobristKeys& keys = zobrist();
+    uint64_t hash = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board[row][col].get();
+            if (piece) {
+                hash ^= keys.pieces[static_cast<int>(piece->color)][static_cast<int>(piece->type)][row * 8 + col];
+            }
+        }
+    }
+    if (currentPlayer == Color::BLACK) hash ^= keys.blackToMove;
+    if (canStillCastle(Color::WHITE, true)) hash ^= keys.castling[0];
+    if (canStillCastle(Color::WHITE, false)) hash ^= keys.castling[1];
+    if (canStillCastle(Color::BLACK, true)) hash ^= keys.castling[2];
+    if (canStillCastle(Color::BLACK, false)) hash ^= keys.castling[3];
+    if (enPassantAvailable) hash ^= keys.enPassantFile[enPassantTarget.col];
+    return hash;
+}
+
+std::string ChessBoard::getUCI(const Move& move) const {
+    std::string uci = move.from.toAlgebraic() + move.to.toAlgebraic();
+    Piece* piece = getPiece(move.from);
+    if (piece && piece->type == PieceType::PAWN && (move.to.row == 0 || move.to.row == 7)) {
+        switch (move.promotionPiece) {
+            case PieceType::ROOK: uci += 'r'; break;
+            case PieceType::BISHOP: uci += 'b'; break;
+            case PieceType::KNIGHT: uci += 'n'; break;
+            default: uci += 'q'; break;
+        }
+    }
+    return uci;
+}
+
+std::string ChessBoard::getSAN(const Move& move) const {
+    Piece* piece = getPiece(move.from);
+    if (!piece) return "";
+
+    std::string san;
+    bool isCapture = getPiece(move.to) != nullptr ||
+                     (piece->type == PieceType::PAWN && move.from.col != move.to.col);
+
+    if (piece->type == PieceType::KING && abs(move.to.col - move.from.col) == 2) {
+        san = (move.to.col > move.from.col) ? "O-O" : "O-O-O";
+    } else if (piece->type == PieceType::PAWN) {
+        if (isCapture) {
+            san += (char)('a' + move.from.col);
+            san += 'x';
+        }
+        san += move.to.toAlgebraic();
+        if (move.to.row == 0 || move.to.row == 7) {
+            san += '=';
+            san += (char)std::toupper(getUCI(move).back());
+        }
+    } else {
+        san += (char)std::toupper(piece->getSymbol());
+
+        // Disambiguate between identical pieces that can reach the same square
+        bool sameFile = false, sameRank = false, ambiguous = false;
+        for (const auto& other : getAllLegalMoves(piece->color)) {
+            if (other.to == move.to && !(other.from == move.from)) {
+                Piece* otherPiece = getPiece(other.from);
+                if (otherPiece->type == piece->type) {
+                    ambiguous = true;
+                    if (other.from.col == move.from.col) sameFile = true;
+                    if (other.from.row == move.from.row) sameRank = true;
+                }
+            }
+        }
+        if (ambiguous) {
+            if (!sameFile) {
+                san += (char)('a' + move.from.col);
+            } else if (!sameRank) {
+                san += (char)('1' + move.from.row);
+            } else {
+                san += move.from.toAlgebraic();
+            }
+        }
+        if (isCapture) san += 'x';
+        san += move.to.toAlgebraic();
+    }
+
+    // Check and checkmate suffix
+    ChessBoard tempBoard = *this;
+    tempBoard.movePiece(move);
+    Color enemyColor = (piece->color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    if (tempBoard.isInCheck(enemyColor)) {
+        san += tempBoard.getAllLegalMoves(enemyColor).empty() ? "#" : "+";
+    }
+    return san;
+}
+
+namespace {
+
+// Piece letter as used in SAN (upper case); anything else reads as a queen
+PieceType pieceTypeFromSymbol(char symbol) {
+    switch (symbol) {
+        case 'K': return PieceType::KING;
+        case 'R': return PieceType::ROOK;
+        case 'B': return PieceType::BISHOP;
+        case 'N': return PieceType::KNIGHT;
+        default: return PieceType::QUEEN;
+    }
+}
+
+} // namespace
+
+bool ChessBoard::parseSAN(const std::string& san, Color color, Move& move) const {
+    std::string text = san;
+    while (!text.empty() && std::strchr("+#!?", text.back())) text.pop_back();
+
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        Position king = getKingPosition(color);
+        int step = (text.length() == 3) ? 2 : -2;
+        move = Move(king, Position(king.row, king.col + step));
+        return isLegal(move);
+    }
+
+    // Promotion, written "e8=Q" or "e8Q"
+    PieceType promotion = PieceType::QUEEN;
+    size_t equals = text.find('=');
+    if (equals != std::string::npos && equals + 1 < text.length()) {
+        promotion = pieceTypeFromSymbol(text[equals + 1]);
+        text.erase(equals);
+    } else if (text.length() > 2 && std::islower(static_cast<unsigned char>(text[0])) && std::strchr("QRBN", text.back())) {
+        promotion = pieceTypeFromSymbol(text.back());
+        text.pop_back();
+    }
+
+    PieceType type = PieceType::PAWN;
+    if (!text.empty() && std::strchr("KQRBN", text[0])) {
+        type = pieceTypeFromSymbol(text[0]);
+        text.erase(0, 1);
+    }
+    text.erase(std::remove_if(text.begin(), text.end(), [](char c) { return c == 'x' || c == ':' || c == '-'; }),
+               text.end());
+    if (text.length() < 2 || text.length() > 4) return false;
+
+    Position to = Position::fromAlgebraic(text.substr(text.length() - 2));
+    if (!to.isValid()) return false;
+    // Whatever precedes the target square narrows down the moving piece
+    int fromCol = -1, fromRow = -1;
+    for (size_t i = 0; i + 2 < text.length(); i++) {
+        if (text[i] >= 'a' && text[i] <= 'h') fromCol = text[i] - 'a';
+        else if (text[i] >= '1' && text[i] <= '8') fromRow = text[i] - '1';
+        else return false;
+    }
+
+    bool found = false;
+    for (int row = 0; row < 8; row++) {
+        if (fromRow >= 0 && row != fromRow) continue;
+        for (int col = 0; col < 8; col++) {
+            if (fromCol >= 0 && col != fromCol) continue;
+            Piece* piece = board[row][col].get();
+            if (!piece || piece->color != color || piece->type != type) continue;
+
+            Move candidate(Position(row, col), to, promotion);
+            if (!isLegal(candidate)) continue;
+            if (found) return false;
+            move = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool ChessBoard::hasInsufficientMaterial() const {
+    int minorPieces = 0;
+    int bishopSquareColors[2] = {0, 0};
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board[row][col].get();
+            if (!piece || piece->type == PieceType::KING) continue;
+            if (piece->type == PieceType::KNIGHT) {
+                minorPieces++;
+            } else if (piece->type == PieceType::BISHOP) {
+                minorPieces++;
+                bishopSquareColors[(row + col) % 2]++;
+            } else {
+                return false;
+            }
+        }
+    }
+    // K vs K, K+minor vs K, or bishops that all live on one square color
+    if (minorPieces <= 1) return true;
+    int bishops = bishopSquareColors[0] + bishopSquareColors[1];
+    return bishops == minorPieces && (bishopSquareColors[0] == 0 || bishopSquareColors[1] == 0);
+}
+
+namespace {
+
+// Indexed by PieceType; capturing the king ends the exchange, so it is worth the most
+const int exchangeValues[6] = {100, 500, 320, 330, 900, 20000};
+
+inline uint64_t squareBit(int row, int col) {
+    return uint64_t(1) << (row * 8 + col);
+}
+
+} // namespace
+
+uint64_t ChessBoard::occupancy() const {
+    uint64_t occupied = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            if (board[row][col]) occupied |= squareBit(row, col);
+        }
+    }
+    return occupied;
+}
+
+bool ChessBoard::leastValuableAttacker(const Position& target, Color color, uint64_t occupied, Position& from,
+                                       uint64_t ignored) const {
+    int bestValue = 0;
+    auto consider = [&](int row, int col, bool (*canAttack)(PieceType)) {
+        if (row < 0 || row > 7 || col < 0 || col > 7) return;
+        if (!(occupied & squareBit(row, col)) || (ignored & squareBit(row, col))) return;
+        Piece* piece = board[row][col].get();
+        if (!piece || piece->color != color || !canAttack(piece->type)) return;
+        int value = exchangeValues[static_cast<int>(piece->type)];
+        if (bestValue == 0 || value < bestValue) {
+            bestValue = value;
+            from = Position(row, col);
+        }
+    };
+
+    // Pawns attack from one rank behind the target, seen from their own side
+    int pawnRow = target.row - ((color == Color::WHITE) ? 1 : -1);
+    auto isPawn = [](PieceType type) { return type == PieceType::PAWN; };
+    consider(pawnRow, target.col - 1, isPawn);
+    consider(pawnRow, target.col + 1, isPawn);
+
+    const int knightJumps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    for (const auto& jump : knightJumps) {
+        consider(target.row + jump[0], target.col + jump[1], [](PieceType type) { return type == PieceType::KNIGHT; });
+    }
+
+    // Sliders: the first occupied square along each ray, so removed pieces reveal x-rays
+    const int directions[8][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    for (int d = 0; d < 8; d++) {
+        bool diagonal = d >= 4;
+        int row = target.row + directions[d][0];
+        int col = target.col + directions[d][1];
+        while (row >= 0 && row < 8 && col >= 0 && col < 8 && !(occupied & squareBit(row, col))) {
+            row += directions[d][0];
+            col += directions[d][1];
+        }
+        if (diagonal) {
+            consider(row, col, [](PieceType type) { return type == PieceType::BISHOP || type == PieceType::QUEEN; });
+        } else {
+            consider(row, col, [](PieceType type) { return type == PieceType::ROOK || type == PieceType::QUEEN; });
+        }
+    }
+
+    for (int d = 0; d < 8; d++) {
+        consider(target.row + directions[d][0], target.col + directions[d][1],
+                 [](PieceType type) { return type == PieceType::KING; });
+    }
+    return bestValue > 0;
+}
+
+int ChessBoard::staticExchange(const Move& move) const {
+    Piece* mover = getPiece(move.from);
+    if (!mover) return 0;
+
+    uint64_t occupied = occupancy();
+
+    bool promotes = mover->type == PieceType::PAWN && (move.to.row == 0 || move.to.row == 7);
+    Piece* victim = getPiece(move.to);
+    int gain[32];
+    gain[0] = victim ? exchangeValues[static_cast<int>(victim->type)] : 0;
+    if (!victim && mover->type == PieceType::PAWN && move.from.col != move.to.col) {
+        // En passant: the captured pawn is beside the target square
+        gain[0] = exchangeValues[static_cast<int>(PieceType::PAWN)];
+        occupied &= ~squareBit(move.from.row, move.to.col);
+    }
+    int onSquare = exchangeValues[static_cast<int>(mover->type)];
+    if (promotes) {
+        int promoted = exchangeValues[static_cast<int>(move.promotionPiece)];
+        gain[0] += promoted - onSquare;
+        onSquare = promoted;
+    }
+    occupied &= ~squareBit(move.from.row, move.from.col);
+
+    // gain[d] is the balance for the side making capture d if the exchange stopped there
+    int depth = 0;
+    Color side = (mover->color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    Position from;
+    while (depth < 31 && leastValuableAttacker(move.to, side, occupied, from)) {
+        Piece* attacker = getPiece(from);
+        Color other = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+        Position unused;
+        // The king may only recapture if nothing can take it back
+        if (attacker->type == PieceType::KING &&
+            leastValuableAttacker(move.to, other, occupied & ~squareBit(from.row, from.col), unused)) {
+            break;
+        }
+
+        depth++;
+        gain[depth] = onSquare - gain[depth - 1];
+        onSquare = exchangeValues[static_cast<int>(attacker->type)];
+        if (attacker->type == PieceType::PAWN && (move.to.row == 0 || move.to.row == 7)) {
+            gain[depth] += exchangeValues[static_cast<int>(PieceType::QUEEN)] - onSquare;
+            onSquare = exchangeValues[static_cast<int>(PieceType::QUEEN)];
+        }
+        occupied &= ~squareBit(from.row, from.col);
+        side = other;
+    }
+
+    // Each side may stop capturing when continuing would lose material
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+bool ChessBoard::isLegal(const Move& move) const {
+    if (!move.from.isValid() || !move.to.isValid() || move.from == move.to) return false;
+    Piece* mover = getPiece(move.from);
+    if (!mover) return false;
+    Piece* target = getPiece(move.to);
+    if (target && target->color == mover->color) return false;
+
+    Color color = mover->color;
+    Color enemy = (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    int rowDelta = move.to.row - move.from.row;
+    int colDelta = move.to.col - move.from.col;
+    uint64_t occupied = occupancy();
+    bool enPassant = false;
+
+    // Sliders need an empty path up to the target square
+    auto pathClear = [&](int rowStep, int colStep) {
+        int row = move.from.row + rowStep;
+        int col = move.from.col + colStep;
+        while (row != move.to.row || col != move.to.col) {
+            if (occupied & squareBit(row, col)) return false;
+            row += rowStep;
+            col += colStep;
+        }
+        return true;
+    };
+    auto sign = [](int value) { return (value > 0) - (value < 0); };
+    bool straight = (rowDelta == 0) != (colDelta == 0);
+    bool diagonal = rowDelta != 0 && std::abs(rowDelta) == std::abs(colDelta);
+
+    switch (mover->type) {
+        case PieceType::PAWN: {
+            int direction = (color == Color::WHITE) ? 1 : -1;
+            int startRow = (color == Color::WHITE) ? 1 : 6;
+            if (colDelta == 0) {
+                if (target) return false;
+                if (rowDelta == 2 * direction) {
+                    if (move.from.row != startRow || !isEmpty(Position(move.from.row + direction, move.from.col))) {
+                        return false;
+                    }
+                } else if (rowDelta != direction) {
+                    return false;
+                }
+            } else {
+                if (std::abs(colDelta) != 1 || rowDelta != direction) return false;
+                if (!target) {
+                    if (!isEnPassantTarget(move.to)) return false;
+                    enPassant = true;
+                }
+            }
+            if ((move.to.row == 0 || move.to.row == 7) &&
+                (move.promotionPiece == PieceType::PAWN || move.promotionPiece == PieceType::KING)) {
+                return false;
+            }
+            break;
+        }
+        case PieceType::KNIGHT:
+            if (std::abs(rowDelta * colDelta) != 2) return false;
+            break;
+        case PieceType::BISHOP:
+            if (!diagonal || !pathClear(sign(rowDelta), sign(colDelta))) return false;
+            break;
+        case PieceType::ROOK:
+            if (!straight || !pathClear(sign(rowDelta), sign(colDelta))) return false;
+            break;
+        case PieceType::QUEEN:
+            if ((!straight && !diagonal) || !pathClear(sign(rowDelta), sign(colDelta))) return false;
+            break;
+        case PieceType::KING:
+            if (rowDelta == 0 && std::abs(colDelta) == 2) {
+                // canCastle covers rights, blockers, and the king's start and transit squares
+                return !mover->hasMoved && canCastle(color, colDelta > 0);
+            }
+            if (std::abs(rowDelta) > 1 || std::abs(colDelta) > 1) return false;
+            break;
+    }
+
+    // The king must not be attacked once the move is made. Lines through the vacated
+    // square open up, and a captured piece blocks nothing and attacks nothing.
+    occupied = (occupied & ~squareBit(move.from.row, move.from.col)) | squareBit(move.to.row, move.to.col);
+    if (enPassant) occupied &= ~squareBit(move.from.row, move.to.col);
+    Position kingPos = (mover->type == PieceType::KING) ? move.to : getKingPosition(color);
+    if (!kingPos.isValid()) return true;
+
+    Position attacker;
+    return !leastValuableAttacker(kingPos, enemy, occupied, attacker, squareBit(move.to.row, move.to.col));
+}
+
+bool ChessBoard::canStillCastle(Color color, bool kingSide) const {
+    int row = (color == Color::WHITE) ? 0 : 7;
+    Piece* king = getPiece(Position(row, 4));
+    Piece* rook = getPiece(Position(row, kingSide ? 7 : 0));
+    return king && king->type == PieceType::KING && king->color == color && !king->hasMoved &&
+           rook && rook->type == PieceType::ROOK && rook->color == color && !rook->hasMoved;
+}
 
 bool ChessBoard::canCastle(Color color, bool kingSide) const {
     Position kingPos = getKingPosition(color);
@@ -372,8 +1005,7 @@ bool ChessBoard::canCastle(Color color, bool kingSide) const {
     int kingDirection = kingSide ? 1 : -1;
 
     for (int i = 1; i <= 2; i++) {
-        Position checkPos(row, kingPos.col + i * kingDirection);
-        if (isSquareAttacked(checkPos, enemyColor,true)) return false;
+        if (attackCount(Position(row, kingPos.col + i * kingDirection), enemyColor) > 0) return false;
     }
 
     return true;
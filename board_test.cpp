@@ -0,0 +1,168 @@
+// Tests for ChessBoard: move generation, the incrementally kept attack maps and
+// king squares, isLegal and staticExchange
+#include "tests.h"
+#include "chess.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+const char* KIWIPETE_FEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+const char* PERFT3_FEN = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1";
+const char* PERFT4_FEN = "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1";
+const char* PERFT5_FEN = "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8";
+
+ChessBoard boardFromFEN(const std::string& fen, Color& sideToMove) {
+    ChessBoard board;
+    board.setFromFEN(fen, sideToMove);
+    return board;
+}
+
+// Whether the attack counts and king squares movePiece maintained match those of
+// a board built from scratch
+bool attackMapsMatch(const ChessBoard& board, Color sideToMove) {
+    Color side;
+    ChessBoard fresh = boardFromFEN(board.getFEN(sideToMove), side);
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        if (!(board.getKingPosition(color) == fresh.getKingPosition(color))) return false;
+        for (int square = 0; square < 64; square++) {
+            Position pos(square / 8, square % 8);
+            if (board.attackCount(pos, color) != fresh.attackCount(pos, color)) return false;
+        }
+    }
+    return true;
+}
+
+// Counts leaf nodes. Every move is played, including those of the last ply, and
+// mapsMatch turns false at the first position whose attack maps differ from a
+// fresh board's.
+long long perft(const ChessBoard& board, Color side, int depth, bool& mapsMatch) {
+    long long nodes = 0;
+    for (const Move& move : board.getAllLegalMoves(side)) {
+        ChessBoard next = board;
+        next.movePiece(move);
+        if (mapsMatch && !attackMapsMatch(next, opposite(side))) mapsMatch = false;
+        nodes += (depth == 1) ? 1 : perft(next, opposite(side), depth - 1, mapsMatch);
+    }
+    return nodes;
+}
+
+bool testPerft() {
+    struct Case {
+        const char* name;
+        const char* fen;
+        int depth;
+        long long nodes;
+    };
+    const Case cases[] = {
+        {"startpos", START_FEN, 3, 8902},
+        {"Kiwipete", KIWIPETE_FEN, 3, 97862},
+        {"position 3", PERFT3_FEN, 4, 43238},
+        {"position 4", PERFT4_FEN, 3, 9467},
+        {"position 5", PERFT5_FEN, 3, 62379},
+    };
+
+    bool ok = true;
+    for (const Case& c : cases) {
+        Color side;
+        ChessBoard board = boardFromFEN(c.fen, side);
+        bool mapsMatch = true;
+        long long nodes = perft(board, side, c.depth, mapsMatch);
+        std::string name = std::string("perft ") + c.name + " depth " + std::to_string(c.depth);
+        ok &= check(nodes == c.nodes, name + " = " + std::to_string(c.nodes) + " (got " + std::to_string(nodes) + ")");
+        ok &= check(mapsMatch, name + ": attack maps and king squares match a fresh board");
+    }
+    return ok;
+}
+
+// isLegal must accept exactly the moves getAllLegalMoves generates, for either
+// side, over every from/to pair and every promotion piece
+bool testIsLegal() {
+    const char* fens[] = {
+        KIWIPETE_FEN,
+        PERFT3_FEN,
+        PERFT4_FEN,
+        PERFT5_FEN,
+        "4k3/8/8/8/4r3/8/4R3/4K3 w - - 0 1",                // Rook pinned along its file
+        "4k3/8/8/7b/8/5N2/8/3K4 w - - 0 1",                 // Knight pinned on a diagonal
+        "4k3/8/8/8/8/8/4q3/4K3 w - - 0 1",                  // King in check from an adjacent queen
+        "8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1",                // En passant
+        "8/8/8/8/k2Pp2Q/8/8/4K3 b - d3 0 1",                // En passant exposing the king along the rank
+        "r3k2r/8/8/8/8/8/5r2/R3K2R w KQkq - 0 1",           // Castling through an attacked f1
+        "r3k2r/8/8/8/8/8/3r4/R3K2R w KQkq - 0 1",           // Castling through an attacked d1
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",             // Castling both ways
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",          // Promotions, with and without captures
+    };
+    const PieceType promotions[] = {PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT};
+
+    bool ok = true;
+    for (const char* fen : fens) {
+        Color side;
+        ChessBoard board = boardFromFEN(fen, side);
+        int mismatches = 0;
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            std::vector<Move> legal = board.getAllLegalMoves(color);
+            for (int from = 0; from < 64; from++) {
+                Position fromPos(from / 8, from % 8);
+                Piece* piece = board.getPiece(fromPos);
+                if (!piece || piece->color != color) continue;
+                for (int to = 0; to < 64; to++) {
+                    Position toPos(to / 8, to % 8);
+                    bool promotes = piece->type == PieceType::PAWN && (toPos.row == 0 || toPos.row == 7);
+                    for (PieceType promotion : promotions) {
+                        if (!promotes && promotion != PieceType::QUEEN) break;
+                        Move move(fromPos, toPos, promotion);
+                        bool generated = false;
+                        for (const Move& candidate : legal) generated |= candidate == move;
+                        if (board.isLegal(move) != generated) mismatches++;
+                    }
+                }
+            }
+        }
+        ok &= check(mismatches == 0, std::string("isLegal matches getAllLegalMoves: ") + fen +
+                    (mismatches ? " (" + std::to_string(mismatches) + " mismatches)" : ""));
+    }
+    return ok;
+}
+
+// Fixed exchanges, valued pawn 100, knight 320, bishop 330, rook 500, queen 900
+bool testStaticExchange() {
+    struct Case {
+        const char* name;
+        const char* fen;
+        const char* move;
+        int value;
+    };
+    const Case cases[] = {
+        {"pawn takes an undefended knight", "4k3/8/8/3n4/4P3/8/8/4K3 w - - 0 1", "e4d5", 320},
+        {"x-ray: queen behind the rook wins a rook-defended pawn", "3rk3/8/8/3p4/8/8/3R4/3QK3 w - - 0 1", "d2d5", 100},
+        {"x-ray: rook and queen batteries on both sides", "3qk3/3r4/8/3p4/8/8/3R4/3QK3 w - - 0 1", "d2d5", -400},
+        {"en passant capture", "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100},
+        {"defended en passant capture", "4k3/2p5/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 0},
+        {"only the king can capture", "4k3/8/8/8/8/8/3p4/4K3 w - - 0 1", "e1d2", 100},
+        {"queen takes a pawn only the king defends", "4k3/3p4/8/8/8/8/8/3QK3 w - - 0 1", "d1d7", -800},
+        {"king cannot recapture a defended queen", "4k3/3p4/8/1B6/8/8/8/3QK3 w - - 0 1", "d1d7", 100},
+        {"quiet push to an attacked square", "4k3/8/8/3p4/8/4P3/8/4K3 w - - 0 1", "e3e4", -100},
+        {"quiet push to a defended square", "4k3/8/8/3p4/8/4PP2/8/4K3 w - - 0 1", "e3e4", 0},
+    };
+
+    bool ok = true;
+    for (const Case& c : cases) {
+        Color side;
+        ChessBoard board = boardFromFEN(c.fen, side);
+        int value = board.staticExchange(Move::fromUCI(c.move));
+        ok &= check(value == c.value, std::string("staticExchange: ") + c.name + " = " + std::to_string(c.value) +
+                    " (got " + std::to_string(value) + ")");
+    }
+    return ok;
+}
+
+} // namespace
+
+bool runBoardTests() {
+    bool ok = testPerft();
+    ok &= testIsLegal();
+    ok &= testStaticExchange();
+    return ok;
+}
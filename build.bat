@@ -1,11 +1,27 @@
 @echo off
 echo Building C++ Chess Game...
 
-g++ -std=c++14 -Wall -Wextra -O2 main.cpp piece.cpp board.cpp game.cpp -o chess.exe
+rem Set CHESS_PROFILE=1 to compile in hot-path instrumentation
+set EXTRA_FLAGS=
+if "%CHESS_PROFILE%"=="1" set EXTRA_FLAGS=-DCHESS_PROFILE
+
+rem Set CHESS_LOG_MIN_LEVEL=trace or debug to compile in the verbose log statements
+if "%CHESS_LOG_MIN_LEVEL%"=="trace" set EXTRA_FLAGS=%EXTRA_FLAGS% -DCHESS_LOG_MIN_LEVEL=0
+if "%CHESS_LOG_MIN_LEVEL%"=="debug" set EXTRA_FLAGS=%EXTRA_FLAGS% -DCHESS_LOG_MIN_LEVEL=1
+
+g++ -std=c++14 -Wall -Wextra -O2 -pthread %EXTRA_FLAGS% main.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp tournament.cpp profiler.cpp analysis_cache.cpp engine_pool.cpp analysis.cpp position_index.cpp mate_solver.cpp training_data.cpp uci_frontend.cpp log.cpp -o chess.exe
+
+rem Micro-benchmarks for the board primitives
+if %errorlevel% equ 0 g++ -std=c++14 -Wall -Wextra -O2 -pthread %EXTRA_FLAGS% bench.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp profiler.cpp analysis_cache.cpp position_index.cpp log.cpp -o chess_bench.exe
+
+rem Regression tests; chess_tests.exe exits non-zero if any test fails
+if %errorlevel% equ 0 g++ -std=c++14 -Wall -Wextra -O2 -pthread %EXTRA_FLAGS% tests.cpp board_test.cpp position_index_test.cpp uci_engine_test.cpp uci_frontend_test.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp profiler.cpp analysis_cache.cpp position_index.cpp uci_frontend.cpp log.cpp -o chess_tests.exe
 
 if %errorlevel% equ 0 (
     echo Build successful!
     echo Run the game with: chess.exe
+    echo Run the benchmarks with: chess_bench.exe
+    echo Run the tests with: chess_tests.exe
 ) else (
     echo Build failed!
     pause
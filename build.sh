@@ -3,12 +3,37 @@
 
 echo "Building C++ Chess Game..."
 
+# Set CHESS_PROFILE=1 to compile in hot-path instrumentation
+EXTRA_FLAGS=""
+if [ "$CHESS_PROFILE" = "1" ]; then
+    EXTRA_FLAGS="-DCHESS_PROFILE"
+fi
+
+# Set CHESS_LOG_MIN_LEVEL=trace or debug to compile in the verbose log statements
+if [ "$CHESS_LOG_MIN_LEVEL" = "trace" ]; then
+    EXTRA_FLAGS="$EXTRA_FLAGS -DCHESS_LOG_MIN_LEVEL=0"
+elif [ "$CHESS_LOG_MIN_LEVEL" = "debug" ]; then
+    EXTRA_FLAGS="$EXTRA_FLAGS -DCHESS_LOG_MIN_LEVEL=1"
+fi
+
 # Compile the game
-g++ -std=c++14 -Wall -Wextra -O2 main.cpp piece.cpp board.cpp game.cpp -o chess
+g++ -std=c++14 -Wall -Wextra -O2 -pthread $EXTRA_FLAGS main.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp tournament.cpp profiler.cpp analysis_cache.cpp engine_pool.cpp analysis.cpp position_index.cpp mate_solver.cpp training_data.cpp uci_frontend.cpp log.cpp -o chess
+
+if [ $? -eq 0 ]; then
+    # Micro-benchmarks for the board primitives
+    g++ -std=c++14 -Wall -Wextra -O2 -pthread $EXTRA_FLAGS bench.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp profiler.cpp analysis_cache.cpp position_index.cpp log.cpp -o chess_bench
+fi
+
+if [ $? -eq 0 ]; then
+    # Regression tests; chess_tests exits non-zero if any test fails
+    g++ -std=c++14 -Wall -Wextra -O2 -pthread $EXTRA_FLAGS tests.cpp board_test.cpp position_index_test.cpp uci_engine_test.cpp uci_frontend_test.cpp piece.cpp board.cpp game.cpp search.cpp move_ordering.cpp engine_process.cpp uci_engine.cpp profiler.cpp analysis_cache.cpp position_index.cpp uci_frontend.cpp log.cpp -o chess_tests
+fi
 
 if [ $? -eq 0 ]; then
     echo "Build successful!"
     echo "Run the game with: ./chess"
+    echo "Run the benchmarks with: ./chess_bench"
+    echo "Run the tests with: ./chess_tests"
 else
     echo "Build failed!"
     exit 1
@@ -7,12 +7,17 @@
 #include <string>
 #include <map>
 #include <cstdlib>
+#include <cstdint>
 #include <sstream>
 #include <fstream>
 
 enum class Color { WHITE, BLACK };
 enum class PieceType { PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING };
 
+inline Color opposite(Color color) {
+    return (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+}
+
 
 
 struct Position {
@@ -42,6 +47,13 @@ struct Move {
 
     Move(Position f, Position t) : from(f), to(t) {}
     Move(Position f, Position t, PieceType promo) : from(f), to(t), promotionPiece(promo) {}
+
+    bool operator==(const Move& other) const {
+        return from == other.from && to == other.to && promotionPiece == other.promotionPiece;
+    }
+
+    // Convert UCI long algebraic notation (e.g., "e2e4", "e7e8q") to Move
+    static Move fromUCI(const std::string& uci);
 };
 
 class Piece {
@@ -111,6 +123,25 @@ private:
     std::unique_ptr<Piece> board[8][8];
     Position enPassantTarget;
     bool enPassantAvailable;
+    int halfmoveClock;
+    int fullmoveNumber;
+
+    // Square of each king, indexed by Color; (-1, -1) when there is none
+    Position kingSquares[2];
+    // Pieces of each color attacking each square (row * 8 + col), kings included.
+    // Kept up to date by movePiece, so attack and check tests are lookups.
+    uint8_t attackCounts[2][64];
+
+    // Adds delta to the count of every square the piece on square attacks
+    void updateAttacks(int square, int delta);
+    // Recomputes king squares and attack counts from the pieces on the board
+    void rebuildAttackMaps();
+
+    // Cheapest piece of color attacking target, counting only squares set in occupied.
+    // Pieces on ignored squares still block lines but do not attack (they were captured).
+    bool leastValuableAttacker(const Position& target, Color color, uint64_t occupied, Position& from,
+                               uint64_t ignored = 0) const;
+    uint64_t occupancy() const;
 
 public:
     ChessBoard();
@@ -128,23 +159,58 @@ public:
     bool isEmpty(const Position& pos) const;
     bool movePiece(const Move& move);
 
+    // Kings only count as attackers when castling_check is set
     bool isSquareAttacked(const Position& pos, Color attackingColor,bool castling_check) const;
+    // Number of pieces of attackingColor attacking pos, kings included
+    int attackCount(const Position& pos, Color attackingColor) const {
+        return attackCounts[static_cast<int>(attackingColor)][pos.row * 8 + pos.col];
+    }
     bool isInCheck(Color kingColor) const;
     bool wouldBeInCheck(const Move& move, Color kingColor) const;
+    // Whether the piece on move.from may make this move, checked directly from the
+    // movement rules and the attacks on its king; no move list is generated
+    bool isLegal(const Move& move) const;
 
     std::vector<Move> getAllLegalMoves(Color color) const;
     bool isCheckmate(Color color) const;
     bool isStalemate(Color color) const;
 
-    Position getKingPosition(Color color) const;
+    Position getKingPosition(Color color) const { return kingSquares[static_cast<int>(color)]; }
     bool canCastle(Color color, bool kingSide) const;
+    // Castling rights only (king and rook unmoved), ignoring checks and blockers
+    bool canStillCastle(Color color, bool kingSide) const;
 
     std::string getFEN(Color currentPlayer) const;
+    bool setFromFEN(const std::string& fen, Color& sideToMove);
+    // FEN without move counters; equal keys mean the same position for repetition checks
+    std::string getPositionKey(Color currentPlayer) const;
+    // 64-bit Zobrist hash of the same information as getPositionKey
+    uint64_t getHash(Color currentPlayer) const;
+    std::string getUCI(const Move& move) const;
+    std::string getSAN(const Move& move) const;
+    // Finds the legal move of color written in SAN ("Nbd7", "exd5", "e8=Q+", "O-O").
+    // Returns false if no move or more than one move matches.
+    bool parseSAN(const std::string& san, Color color, Move& move) const;
+    bool hasInsufficientMaterial() const;
+    // Material won (in centipawns, negative if lost) by the capture sequence that move
+    // starts on its target square, each side recapturing with its cheapest attacker.
+    // Sliders behind other attackers join in as the squares in front clear. Works on
+    // an occupancy mask, so no move is ever made on the board.
+    int staticExchange(const Move& move) const;
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
     void setEnPassant(const Position& pos) { enPassantTarget = pos; enPassantAvailable = true; }
     void clearEnPassant() { enPassantAvailable = false; }
     bool isEnPassantTarget(const Position& pos) const { return enPassantAvailable && enPassantTarget == pos; }
 };
 
+// Path to the Stockfish executable, relative to the working directory or absolute
+#define DEFAULT_STOCKFISH_PATH "stockfish.exe"
+
+class UciEngine;
+class PositionIndex;
+struct SearchLimits;
+
 class ChessGame {
 private:
     ChessBoard board;
@@ -156,9 +222,33 @@ private:
     Color cpuColor;
     Color humanColor;
 
+    // Persistent engine process, started on the CPU's first move
+    std::string enginePath;
+    std::unique_ptr<UciEngine> engine;
+    std::string lastMove;       // UCI notation of the last move played, for ponder hits
+    std::string expectedReply;  // Engine's predicted human reply, pondered on the human's time
+
+    // Opening explorer data, opened on the first 'explore' command
+    std::unique_ptr<PositionIndex> positionIndex;
+
+    // Game clock in milliseconds; disabled until setTimeControl is called
+    bool clockEnabled;
+    int whiteTimeMs;
+    int blackTimeMs;
+    int incrementMs;
+
+    // Engine budget per move when there is no clock, and the hard deadline
+    int engineMoveTimeMs;
+    long long engineNodes;
+    int engineDeadlineMs;
 
 public:
-     ChessGame(bool enableCPU, Color cpuPlaysAs = Color::BLACK);
+     ChessGame(bool enableCPU, Color cpuPlaysAs = Color::BLACK, const std::string& enginePath = DEFAULT_STOCKFISH_PATH);
+    ~ChessGame();
+
+    void setTimeControl(int baseMs, int incrementMs);
+    // Zero leaves a limit unset; the deadline applies to every engine move
+    void setEngineLimits(int moveTimeMs, long long nodes, int deadlineMs);
 
     void startGame();
     void playTurn();
@@ -167,11 +257,22 @@ public:
     Color getCurrentPlayer() const { return currentPlayer; }
     bool isGameOver() const { return gameOver; }
     std::string getGameResult() const { return gameResult; }
-    private:
+    // Parses coordinate notation such as "e2e4", "e2-e4" or "e7e8q"
     Move parseAlgebraicNotation(const std::string& notation) const;
+    private:
     void checkGameEnd();
+    SearchLimits buildEngineLimits() const;
+    std::string requestEngineMove();
+    void startPondering();
+    // Reads a line from the console, processing engine output while the engine ponders
+    std::string readHumanInput();
+    // Prints the games in the position index that reached the current position
+    void showExplorer();
+    // Charges elapsed time to the player, adding the increment once a move is made.
+    // Returns false if their flag fell.
+    bool updateClock(Color player, int elapsedMs, bool moveMade);
     
 };
 
-std::string getBestMoveFromStockfish(const std::string& fen, const std::string& stockfishPath = "stockfish.exe");
+std::string getBestMoveFromStockfish(const std::string& fen, const std::string& stockfishPath = DEFAULT_STOCKFISH_PATH);
 #endif // CHESS_H
@@ -0,0 +1,257 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "chess.h"
+#include "analysis_cache.h"
+#include "move_ordering.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+// Limits for a single search. Zero means "not set".
+struct SearchLimits {
+    int depth = 0;
+    long long nodes = 0;
+    int movetimeMs = 0;
+
+    // Clock state, in milliseconds
+    int wtimeMs = 0;
+    int btimeMs = 0;
+    int wincMs = 0;
+    int bincMs = 0;
+
+    // Hard cap on wall time; the search is stopped and its current best move taken
+    int deadlineMs = 0;
+
+    // Number of best lines to search and report (UCI "MultiPV")
+    int multiPV = 1;
+
+    // Set from another thread to end the built-in search early; it then returns
+    // its best move so far
+    const std::atomic<bool>* stop = nullptr;
+
+    bool hasClock() const { return wtimeMs > 0 || btimeMs > 0; }
+};
+
+struct SearchResult {
+    std::string bestMove;   // UCI notation (e.g., "e2e4"), empty if no move was found
+    int score = 0;          // Centipawns from the side to move's point of view
+    bool isMate = false;    // When set, score is "mate in N" moves instead of centipawns
+    int depth = 0;
+    long long nodes = 0;
+    std::string ponderMove; // Expected reply suggested by the engine, if any
+    std::vector<std::string> pv;
+    bool cancelled = false; // The search was stopped by cancel() before it finished
+};
+
+// One "info" update streamed by a UCI engine while it searches
+struct SearchInfo {
+    int depth = 0;
+    int multipv = 1;
+    int score = 0;
+    bool isMate = false;
+    bool hasScore = false;
+    long long nodes = 0;
+    int timeMs = 0;
+    std::vector<std::string> pv;
+};
+
+using InfoCallback = std::function<void(const SearchInfo&)>;
+
+// Parses a UCI "info ..." line; returns false for lines that are not info lines
+bool parseInfoLine(const std::string& line, SearchInfo& info);
+
+// Time to spend on one move: movetime if given, otherwise a slice of the clock
+int allocateMoveTime(const SearchLimits& limits, Color sideToMove);
+
+class Engine {
+public:
+    virtual ~Engine() = default;
+
+    virtual std::string getName() const = 0;
+    virtual void newGame() {}
+    virtual SearchResult search(const ChessBoard& board, Color sideToMove, const SearchLimits& limits) = 0;
+
+    // Receives the engine's progress during search(): each line of each completed depth
+    void setInfoCallback(InfoCallback callback) { infoCallback = std::move(callback); }
+
+protected:
+    InfoCallback infoCallback;
+};
+
+// In-process alpha-beta search on top of ChessBoard
+class BuiltinEngine : public Engine {
+public:
+    static const int MATE_SCORE = 100000;
+    static const int MAX_DEPTH = 64;
+
+    BuiltinEngine();
+
+    std::string getName() const override { return "Builtin"; }
+    void newGame() override;
+    SearchResult search(const ChessBoard& board, Color sideToMove, const SearchLimits& limits) override;
+
+    static int evaluate(const ChessBoard& board, Color sideToMove);
+
+private:
+    // Best move found for a position, so the next iteration (or a transposition) tries it first
+    struct HashMoveEntry {
+        uint64_t key = 0;
+        uint16_t move = 0;
+    };
+    static const size_t HASH_MOVE_ENTRIES = 1 << 16;
+
+    int negamax(const ChessBoard& board, Color sideToMove, int depth, int alpha, int beta, int ply,
+                const Move* previousMove);
+    // Resolves captures (or check evasions) at the leaves so the static evaluation
+    // is never taken in the middle of an exchange
+    int quiescence(const ChessBoard& board, Color sideToMove, int alpha, int beta, int ply);
+    bool shouldStop();
+    // Principal variation collected at the root, in UCI notation
+    std::vector<std::string> rootPV(const ChessBoard& board) const;
+
+    long long nodes = 0;
+    long long nodeLimit = 0;
+    const std::atomic<bool>* stopFlag = nullptr;
+    bool hasDeadline = false;
+    bool stopped = false;
+    std::chrono::steady_clock::time_point deadline;
+    std::string rootBestMove;
+    std::string previousBestMove;
+    MoveOrdering ordering;
+    std::vector<HashMoveEntry> hashMoves;
+    std::chrono::steady_clock::time_point searchStart;
+
+    // Root moves already reported as better lines in this iteration (multi-PV)
+    std::vector<uint16_t> excludedRootMoves;
+    // Triangular PV table: pvTable[ply] holds the best line from ply onwards
+    uint16_t pvTable[MoveOrdering::MAX_PLY][MoveOrdering::MAX_PLY];
+    int pvLength[MoveOrdering::MAX_PLY];
+};
+
+// Child process with line-based stdin/stdout pipes, used to talk to UCI engines
+class EngineProcess {
+public:
+    EngineProcess();
+    ~EngineProcess();
+    EngineProcess(const EngineProcess&) = delete;
+    EngineProcess& operator=(const EngineProcess&) = delete;
+
+    bool start(const std::string& path);
+    void stop();
+    bool isRunning() const { return running; }
+
+    enum class ReadResult { LINE, TIMEOUT, CLOSED };
+
+    bool writeLine(const std::string& line);
+    // Blocks until a full line is available; returns false on EOF or error
+    bool readLine(std::string& line);
+    // Waits at most timeoutMs (negative means forever) for a full line
+    ReadResult readLine(std::string& line, int timeoutMs);
+
+private:
+    bool takePendingLine(std::string& line);
+
+    bool running;
+    std::string pending;
+#ifdef _WIN32
+    void* processHandle;
+    void* stdinWrite;
+    void* stdoutRead;
+#else
+    int pid;
+    int stdinFd;
+    int stdoutFd;
+#endif
+};
+
+// External engine speaking the UCI protocol, kept alive across searches
+class UciEngine : public Engine {
+public:
+    explicit UciEngine(const std::string& path);
+    ~UciEngine() override;
+
+    bool start();
+    bool isRunning() const { return process.isRunning(); }
+    // Round trip of "isready"; false if the engine is gone or does not answer in time
+    bool ping(int timeoutMs);
+    void setOption(const std::string& name, const std::string& value);
+
+    std::string getName() const override { return name; }
+    void newGame() override;
+    SearchResult search(const ChessBoard& board, Color sideToMove, const SearchLimits& limits) override;
+    SearchResult searchFEN(const std::string& fen, const SearchLimits& limits);
+
+    // Asynchronous search. Returns at once; the engine's output is processed by
+    // poll(), which streams info updates to onInfo and fulfils the future when
+    // "bestmove" arrives. Each engine runs one search at a time, so a frontend can
+    // interleave many games on one thread by calling poll(0) on each engine.
+    std::future<SearchResult> requestBestMove(const std::string& fen, const SearchLimits& limits,
+                                              InfoCallback onInfo = nullptr);
+    // Processes engine output for up to timeoutMs (negative waits until the search
+    // finishes). Returns true while a search is still running.
+    bool poll(int timeoutMs = 0);
+    // Asks the engine to stop; the future then completes with cancelled set
+    void cancel();
+    bool isSearching() const { return active != nullptr; }
+
+    // Cache consulted before every search and filled after it; off (nullptr) by
+    // default. Entries are keyed by the position, the engine's id name and the
+    // options set, so other engines and configurations never share answers.
+    void setAnalysisCache(AnalysisCache* analysisCache) { cache = analysisCache; }
+
+    // Pondering: search the position after expectedMove while the opponent thinks.
+    // On a hit, ponderHit turns it into a normal search and returns its result;
+    // on a miss, stopPonder cancels it so a fresh search can start.
+    void startPonder(const std::string& fen, const std::string& expectedMove, const SearchLimits& limits);
+    SearchResult ponderHit(const SearchLimits& limits);
+    void stopPonder();
+    bool isPondering() const { return active && active->ponder; }
+    const std::string& getPonderMove() const { return ponderMove; }
+
+private:
+    struct ActiveSearch {
+        std::promise<SearchResult> promise;
+        InfoCallback onInfo;
+        SearchLimits limits;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point stopTime;
+        bool stopSent = false;
+        bool ponder = false;
+        SearchResult result;
+        std::vector<std::string> pv;
+        uint64_t cacheKey = 0;
+        bool cacheable = false;
+    };
+
+    // Waits for a line starting with token; a negative timeout waits forever
+    bool waitFor(const std::string& token, int timeoutMs = -1);
+    static std::string goCommand(const SearchLimits& limits);
+    std::future<SearchResult> startSearch(const std::string& position, const SearchLimits& limits,
+                                          InfoCallback onInfo, bool ponder);
+    void handleLine(const std::string& line);
+    void sendStop();
+    void finishSearch();
+    // Hash of the id name and the options set, mixed into every cache key
+    uint64_t identityKey() const;
+
+    EngineProcess process;
+    std::string path;
+    std::string name;
+    std::unique_ptr<ActiveSearch> active;
+    int multiPV = 1;                    // Value of the engine's MultiPV option
+    std::map<std::string, std::string> options;     // Set through setOption, except MultiPV
+    AnalysisCache* cache = nullptr;
+    std::future<SearchResult> ponderResult;
+    std::string ponderMove;
+};
+
+// "builtin" creates a BuiltinEngine, anything else is treated as a UCI engine path.
+// Returns nullptr if the engine could not be started.
+std::unique_ptr<Engine> createEngine(const std::string& spec);
+
+#endif // ENGINE_H
@@ -0,0 +1,270 @@
+#include "engine_pool.h"
+#include "json.h"
+#include "log.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// How long an idle engine may take to answer "isready" before it counts as hung
+const int PING_TIMEOUT_MS = 5000;
+
+std::string toJSON(const BatchResult& batch) {
+    std::string json = "{\"id\":" + std::to_string(batch.id) + ",\"fen\":" + jsonString(batch.fen);
+    if (!batch.ok) {
+        return json + ",\"error\":" + jsonString(batch.error) + "}";
+    }
+
+    const SearchResult& result = batch.result;
+    json += ",\"bestmove\":" + jsonString(result.bestMove);
+    json += ",\"score\":{\"" + std::string(result.isMate ? "mate" : "cp") + "\":" + std::to_string(result.score) + "}";
+    json += ",\"depth\":" + std::to_string(result.depth);
+    json += ",\"nodes\":" + std::to_string(result.nodes);
+    json += ",\"pv\":[";
+    for (size_t i = 0; i < result.pv.size(); i++) {
+        json += (i ? "," : "") + jsonString(result.pv[i]);
+    }
+    return json + "]}";
+}
+
+} // namespace
+
+EnginePool::EnginePool(const EnginePoolConfig& config) : config(config) {
+    if (this->config.maxPending == 0) {
+        this->config.maxPending = static_cast<size_t>(8 * std::max(1, config.engines));
+    }
+}
+
+EnginePool::~EnginePool() {
+    close();
+    for (auto& thread : threads) thread.join();
+}
+
+bool EnginePool::start() {
+    for (int i = 0; i < config.engines; i++) {
+        std::unique_ptr<UciEngine> engine = launchEngine();
+        if (!engine) {
+            LOG_ERROR("Engine " << i + 1 << " of " << config.engines << " failed to start");
+            continue;
+        }
+        threads.emplace_back(&EnginePool::worker, this, std::move(engine));
+    }
+    return !threads.empty();
+}
+
+std::unique_ptr<UciEngine> EnginePool::launchEngine() const {
+    auto engine = std::make_unique<UciEngine>(config.enginePath);
+    if (config.useCache) engine->setAnalysisCache(&AnalysisCache::shared());
+    if (!engine->start()) return nullptr;
+
+    engine->setOption("Threads", std::to_string(config.threadsPerEngine));
+    engine->setOption("Hash", std::to_string(config.hashMb));
+    // Resizing the hash can take a while; wait until the engine has applied it
+    engine->newGame();
+    return engine;
+}
+
+SearchLimits EnginePool::jobLimits() const {
+    SearchLimits limits = config.limits;
+    if (limits.deadlineMs == 0) limits.deadlineMs = config.jobTimeoutMs;
+    return limits;
+}
+
+long long EnginePool::submit(const std::string& fen) {
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceAvailable.wait(lock, [this] {
+        return static_cast<size_t>(nextId - nextToDeliver) < config.maxPending;
+    });
+    long long id = nextId++;
+    jobs.push_back(Job{id, fen});
+    jobAvailable.notify_one();
+    return id;
+}
+
+void EnginePool::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    jobAvailable.notify_all();
+    resultAvailable.notify_all();
+}
+
+bool EnginePool::nextResult(BatchResult& result) {
+    std::unique_lock<std::mutex> lock(mutex);
+    resultAvailable.wait(lock, [this] {
+        return finished.count(nextToDeliver) || (closed && nextToDeliver == nextId);
+    });
+
+    auto it = finished.find(nextToDeliver);
+    if (it == finished.end()) return false;
+    result = std::move(it->second);
+    finished.erase(it);
+    nextToDeliver++;
+    spaceAvailable.notify_all();
+    return true;
+}
+
+int EnginePool::restarts() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return restartCount;
+}
+
+void EnginePool::worker(std::unique_ptr<UciEngine> engine) {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return !jobs.empty() || closed; });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        BatchResult result = analyse(engine, job);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished[job.id] = std::move(result);
+        resultAvailable.notify_all();
+    }
+}
+
+BatchResult EnginePool::analyse(std::unique_ptr<UciEngine>& engine, const Job& job) {
+    BatchResult batch;
+    batch.id = job.id;
+    batch.fen = job.fen;
+
+    // Some engines crash on malformed positions, so never send them one
+    ChessBoard board;
+    Color sideToMove;
+    if (!board.setFromFEN(job.fen, sideToMove)) {
+        batch.error = "invalid FEN";
+        return batch;
+    }
+
+    SearchLimits limits = jobLimits();
+    for (int attempt = 0; attempt < config.maxAttempts; attempt++) {
+        if (!engine || !engine->ping(PING_TIMEOUT_MS)) {
+            LOG_WARN("Restarting engine: " << config.enginePath);
+            engine.reset();
+            engine = launchEngine();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                restartCount++;
+            }
+            if (!engine) continue;
+        }
+
+        batch.result = engine->searchFEN(job.fen, limits);
+        // A search cut short by a crash is retried unless it already produced a move;
+        // a live engine answering "(none)" has simply found no legal moves
+        if (engine->isRunning() || !batch.result.bestMove.empty()) {
+            batch.ok = true;
+            return batch;
+        }
+    }
+    batch.error = "engine failed";
+    return batch;
+}
+
+int runAnalyzeCommand(int argc, char* argv[]) {
+    EnginePoolConfig config;
+    std::string inputFile;
+    std::string outputFile;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--engine" && hasValue) {
+            config.enginePath = argv[++i];
+        } else if (arg == "--engines" && hasValue) {
+            config.engines = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            config.threadsPerEngine = std::atoi(argv[++i]);
+        } else if (arg == "--hash" && hasValue) {
+            config.hashMb = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            config.limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            config.limits.nodes = std::atoll(argv[++i]);
+        } else if (arg == "--movetime" && hasValue) {
+            config.limits.movetimeMs = std::atoi(argv[++i]);
+        } else if (arg == "--timeout" && hasValue) {
+            config.jobTimeoutMs = std::atoi(argv[++i]);
+        } else if (arg == "--input" && hasValue) {
+            inputFile = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            outputFile = argv[++i];
+        } else if (arg == "--cache") {
+            config.useCache = true;
+        } else {
+            std::cerr << "Unknown analyze option: " << arg << "\n"
+                      << "Usage: chess analyze [--engine PATH] [--engines N] [--threads N] [--hash MB]\n"
+                      << "       [--depth N] [--nodes N] [--movetime MS] [--timeout MS]\n"
+                      << "       [--input FILE] [--output FILE] [--cache]\n";
+            return 1;
+        }
+    }
+
+    // A bare "go" would let the engines search forever
+    const SearchLimits& limits = config.limits;
+    if (limits.depth == 0 && limits.nodes == 0 && limits.movetimeMs == 0) {
+        config.limits.movetimeMs = 100;
+    }
+    if (config.engines <= 0 || config.threadsPerEngine <= 0 || config.hashMb <= 0) {
+        std::cerr << "Engines, threads and hash must be positive\n";
+        return 1;
+    }
+
+    std::ifstream inFile;
+    if (!inputFile.empty()) {
+        inFile.open(inputFile);
+        if (!inFile) {
+            std::cerr << "Could not open " << inputFile << "\n";
+            return 1;
+        }
+    }
+    std::ofstream outFile;
+    if (!outputFile.empty()) {
+        outFile.open(outputFile);
+        if (!outFile) {
+            std::cerr << "Could not open " << outputFile << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = inputFile.empty() ? std::cin : inFile;
+    std::ostream& out = outputFile.empty() ? std::cout : outFile;
+
+    EnginePool pool(config);
+    if (!pool.start()) {
+        std::cerr << "Failed to start engine: " << config.enginePath << "\n";
+        return 1;
+    }
+
+    // Results are written as JSON lines while positions are still being read
+    auto start = std::chrono::steady_clock::now();
+    long long written = 0;
+    std::thread writer([&] {
+        BatchResult result;
+        while (pool.nextResult(result)) {
+            out << toJSON(result) << "\n";
+            written++;
+        }
+        out.flush();
+    });
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        pool.submit(line);
+    }
+    pool.close();
+    writer.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Analysed " << written << " positions in " << seconds << " s ("
+              << (seconds > 0 ? written / seconds : 0.0) << " positions/s), "
+              << pool.restarts() << " engine restarts\n";
+    return 0;
+}
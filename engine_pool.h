@@ -0,0 +1,89 @@
+#ifndef ENGINE_POOL_H
+#define ENGINE_POOL_H
+
+#include "engine.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct EnginePoolConfig {
+    std::string enginePath = DEFAULT_STOCKFISH_PATH;
+    int engines = 1;                    // Number of engine processes
+    int threadsPerEngine = 1;           // UCI "Threads" option for each process
+    int hashMb = 16;                    // UCI "Hash" option for each process
+    SearchLimits limits;                // Applied to every position
+    int jobTimeoutMs = 60000;           // Hard deadline when limits has none
+    int maxAttempts = 3;                // Per position, counting restarts after a crash
+    size_t maxPending = 0;              // Positions in flight before submit blocks; 0 picks 8 per engine
+    bool useCache = false;              // Consult and fill the shared analysis cache
+};
+
+struct BatchResult {
+    long long id = 0;                   // Submission order, from 0
+    std::string fen;
+    SearchResult result;
+    bool ok = false;
+    std::string error;                  // Why the position could not be analysed, if !ok
+};
+
+// K long-lived UCI engines fed from one job queue. Each process is configured
+// once (Threads, Hash) and then reused, so a large batch pays the startup cost K
+// times instead of once per position. Results come back in submission order.
+//
+// A worker checks its engine with "isready" before every job; an engine that
+// crashed or stopped answering is restarted and the position retried. Searches
+// run under a hard deadline, so an engine that hangs mid-search is stopped too.
+class EnginePool {
+public:
+    explicit EnginePool(const EnginePoolConfig& config);
+    // Waits for queued positions to finish
+    ~EnginePool();
+
+    // Starts the workers; false if not a single engine could be started
+    bool start();
+
+    // Queues a position and returns its id. Blocks while maxPending results are
+    // waiting to be collected, so a huge input never sits in memory all at once.
+    long long submit(const std::string& fen);
+    // No more submissions; nextResult returns false once everything is delivered
+    void close();
+    // Next result in submission order, blocking until it is ready
+    bool nextResult(BatchResult& result);
+
+    int restarts() const;
+
+private:
+    struct Job {
+        long long id;
+        std::string fen;
+    };
+
+    void worker(std::unique_ptr<UciEngine> engine);
+    BatchResult analyse(std::unique_ptr<UciEngine>& engine, const Job& job);
+    std::unique_ptr<UciEngine> launchEngine() const;
+    SearchLimits jobLimits() const;
+
+    EnginePoolConfig config;
+    std::vector<std::thread> threads;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable resultAvailable;
+    std::condition_variable spaceAvailable;
+    std::deque<Job> jobs;
+    std::map<long long, BatchResult> finished;   // Reorder buffer
+    long long nextId = 0;
+    long long nextToDeliver = 0;
+    bool closed = false;
+    int restartCount = 0;
+};
+
+// Entry point for "chess analyze [options]"
+int runAnalyzeCommand(int argc, char* argv[]);
+
+#endif // ENGINE_POOL_H
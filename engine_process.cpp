@@ -0,0 +1,299 @@
+#include "engine.h"
+#include "log.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <csignal>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <sys/types.h>
+    #include <sys/wait.h>
+#endif
+
+bool EngineProcess::readLine(std::string& line) {
+    return readLine(line, -1) == ReadResult::LINE;
+}
+
+bool EngineProcess::takePendingLine(std::string& line) {
+    size_t newline = pending.find('\n');
+    if (newline == std::string::npos) return false;
+    line = pending.substr(0, newline);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    pending.erase(0, newline + 1);
+    LOG_TRACE("engine >> " << line);
+    return true;
+}
+
+#ifdef _WIN32
+
+EngineProcess::EngineProcess()
+    : running(false), processHandle(NULL), stdinWrite(NULL), stdoutRead(NULL) {}
+
+EngineProcess::~EngineProcess() {
+    stop();
+}
+
+bool EngineProcess::start(const std::string& path) {
+    if (running) stop();
+
+    HANDLE hChildStd_IN_Rd = NULL;
+    HANDLE hChildStd_IN_Wr = NULL;
+    HANDLE hChildStd_OUT_Rd = NULL;
+    HANDLE hChildStd_OUT_Wr = NULL;
+
+    SECURITY_ATTRIBUTES saAttr;
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+    saAttr.lpSecurityDescriptor = NULL;
+
+    // Create a pipe for the child process's STDOUT. The default buffer is only a few
+    // KB, which a chatty engine fills with info lines between two reads.
+    const DWORD stdoutBufferBytes = 64 * 1024;
+    if (!CreatePipe(&hChildStd_OUT_Rd, &hChildStd_OUT_Wr, &saAttr, stdoutBufferBytes)) {
+        LOG_ERROR("Stdout pipe creation failed");
+        return false;
+    }
+    // Ensure read handle to STDOUT is not inherited.
+    SetHandleInformation(hChildStd_OUT_Rd, HANDLE_FLAG_INHERIT, 0);
+
+    // Create a pipe for the child process's STDIN.
+    if (!CreatePipe(&hChildStd_IN_Rd, &hChildStd_IN_Wr, &saAttr, 0)) {
+        LOG_ERROR("Stdin pipe creation failed");
+        CloseHandle(hChildStd_OUT_Rd);
+        CloseHandle(hChildStd_OUT_Wr);
+        return false;
+    }
+    SetHandleInformation(hChildStd_IN_Wr, HANDLE_FLAG_INHERIT, 0);
+
+    PROCESS_INFORMATION piProcInfo;
+    ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
+
+    STARTUPINFOA siStartInfo;
+    ZeroMemory(&siStartInfo, sizeof(STARTUPINFOA));
+    siStartInfo.cb = sizeof(STARTUPINFOA);
+    siStartInfo.hStdError = hChildStd_OUT_Wr;
+    siStartInfo.hStdOutput = hChildStd_OUT_Wr;
+    siStartInfo.hStdInput = hChildStd_IN_Rd;
+    siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
+
+    // Start the child process.
+    std::string cmdLine = path;
+    BOOL success = CreateProcessA(
+        NULL,
+        &cmdLine[0],
+        NULL, NULL,
+        TRUE,
+        0,
+        NULL, NULL,
+        &siStartInfo,
+        &piProcInfo
+    );
+
+    // The child owns its ends of the pipes now
+    CloseHandle(hChildStd_IN_Rd);
+    CloseHandle(hChildStd_OUT_Wr);
+
+    if (!success) {
+        LOG_ERROR("CreateProcess failed: " << path);
+        CloseHandle(hChildStd_IN_Wr);
+        CloseHandle(hChildStd_OUT_Rd);
+        return false;
+    }
+    CloseHandle(piProcInfo.hThread);
+
+    processHandle = piProcInfo.hProcess;
+    stdinWrite = hChildStd_IN_Wr;
+    stdoutRead = hChildStd_OUT_Rd;
+    pending.clear();
+    running = true;
+    return true;
+}
+
+void EngineProcess::stop() {
+    if (!running) return;
+    writeLine("quit");
+    if (WaitForSingleObject(processHandle, 500) != WAIT_OBJECT_0) {
+        TerminateProcess(processHandle, 0);
+    }
+    CloseHandle(stdinWrite);
+    CloseHandle(stdoutRead);
+    CloseHandle(processHandle);
+    processHandle = stdinWrite = stdoutRead = NULL;
+    running = false;
+}
+
+bool EngineProcess::writeLine(const std::string& line) {
+    if (!running) return false;
+    LOG_TRACE("engine << " << line);
+    std::string data = line + "\n";
+    DWORD written;
+    return WriteFile(stdinWrite, data.c_str(), data.length(), &written, NULL) && written == data.length();
+}
+
+EngineProcess::ReadResult EngineProcess::readLine(std::string& line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (running) {
+        if (takePendingLine(line)) return ReadResult::LINE;
+
+        // Peek first so a silent engine cannot block us past the timeout
+        DWORD available = 0;
+        if (!PeekNamedPipe(stdoutRead, NULL, 0, NULL, &available, NULL)) return ReadResult::CLOSED;
+        if (available == 0) {
+            if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline) return ReadResult::TIMEOUT;
+            Sleep(1);
+            continue;
+        }
+
+        char buffer[4096];
+        DWORD bytesRead;
+        DWORD toRead = available < sizeof(buffer) ? available : sizeof(buffer);
+        BOOL result = ReadFile(stdoutRead, buffer, toRead, &bytesRead, NULL);
+        if (!result || bytesRead == 0) return ReadResult::CLOSED;
+        pending.append(buffer, bytesRead);
+    }
+    return ReadResult::CLOSED;
+}
+
+#else
+
+namespace {
+
+// Both ends are closed on exec, so an engine started later does not inherit the
+// pipes of another one and keep them open after that engine exits
+bool makePipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+} // namespace
+
+EngineProcess::EngineProcess()
+    : running(false), pid(-1), stdinFd(-1), stdoutFd(-1) {}
+
+EngineProcess::~EngineProcess() {
+    stop();
+}
+
+bool EngineProcess::start(const std::string& path) {
+    if (running) stop();
+
+    int inPipe[2];
+    int outPipe[2];
+    if (!makePipe(inPipe)) {
+        LOG_ERROR("Stdin pipe creation failed");
+        return false;
+    }
+    if (!makePipe(outPipe)) {
+        LOG_ERROR("Stdout pipe creation failed");
+        close(inPipe[0]);
+        close(inPipe[1]);
+        return false;
+    }
+
+    pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("fork failed: " << path);
+        close(inPipe[0]);
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(outPipe[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        dup2(outPipe[1], STDERR_FILENO);
+        close(inPipe[0]);
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(outPipe[1]);
+        execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(inPipe[0]);
+    close(outPipe[1]);
+    stdinFd = inPipe[1];
+    stdoutFd = outPipe[0];
+    pending.clear();
+    running = true;
+    return true;
+}
+
+void EngineProcess::stop() {
+    if (!running) return;
+    writeLine("quit");
+    close(stdinFd);
+    close(stdoutFd);
+
+    // Give the engine a moment to exit on its own before killing it
+    int status;
+    bool exited = false;
+    for (int i = 0; i < 50 && !exited; i++) {
+        exited = waitpid(pid, &status, WNOHANG) == pid;
+        if (!exited) usleep(10000);
+    }
+    if (!exited) {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    }
+
+    pid = stdinFd = stdoutFd = -1;
+    running = false;
+}
+
+bool EngineProcess::writeLine(const std::string& line) {
+    if (!running) return false;
+    LOG_TRACE("engine << " << line);
+    std::string data = line + "\n";
+    size_t offset = 0;
+    while (offset < data.length()) {
+        ssize_t written = write(stdinFd, data.c_str() + offset, data.length() - offset);
+        if (written <= 0) return false;
+        offset += written;
+    }
+    return true;
+}
+
+EngineProcess::ReadResult EngineProcess::readLine(std::string& line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (running) {
+        if (takePendingLine(line)) return ReadResult::LINE;
+
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            waitMs = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+
+        pollfd pfd;
+        pfd.fd = stdoutFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, waitMs);
+        if (ready == 0) return ReadResult::TIMEOUT;
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return ReadResult::CLOSED;
+        }
+
+        char buffer[4096];
+        ssize_t bytesRead = read(stdoutFd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) return ReadResult::CLOSED;
+        pending.append(buffer, bytesRead);
+    }
+    return ReadResult::CLOSED;
+}
+
+#endif
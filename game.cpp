@@ -1,4 +1,10 @@
 #include "chess.h"
+#include "engine.h"
+#include "log.h"
+#include "position_index.h"
+#include "profiler.h"
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <cctype>
@@ -6,28 +12,190 @@
 #include <cstdlib>
 #include <fstream>
 #include <cstdio>
-#include<windows.h>
-#ifdef _WIN32
-    #define popen _popen
-    #define pclose _pclose
-#endif
+#include <iomanip>
 
-ChessGame::ChessGame(bool enableCPU, Color cpuPlaysAs)
+namespace {
+
+// How long each poll of a pondering engine waits for output while the human thinks
+const int PONDER_POLL_MS = 50;
+
+int millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+std::string formatClock(int ms) {
+    int seconds = ms / 1000;
+    std::ostringstream oss;
+    oss << seconds / 60 << ":" << (seconds % 60 < 10 ? "0" : "") << seconds % 60;
+    return oss.str();
+}
+
+} // namespace
+
+ChessGame::ChessGame(bool enableCPU, Color cpuPlaysAs, const std::string& enginePath)
     : currentPlayer(Color::WHITE),
     gameOver(false),
     isCPUEnabled(enableCPU),
     cpuColor(cpuPlaysAs),
-    humanColor(cpuPlaysAs == Color::WHITE ? Color::BLACK : Color::WHITE) {}
+    humanColor(cpuPlaysAs == Color::WHITE ? Color::BLACK : Color::WHITE),
+    enginePath(enginePath),
+    clockEnabled(false),
+    whiteTimeMs(0),
+    blackTimeMs(0),
+    incrementMs(0),
+    engineMoveTimeMs(1000),
+    engineNodes(0),
+    engineDeadlineMs(5000) {}
+
+ChessGame::~ChessGame() = default;
+
+void ChessGame::setTimeControl(int baseMs, int incrementMs) {
+    clockEnabled = baseMs > 0;
+    whiteTimeMs = blackTimeMs = baseMs;
+    this->incrementMs = incrementMs;
+}
+
+void ChessGame::setEngineLimits(int moveTimeMs, long long nodes, int deadlineMs) {
+    engineMoveTimeMs = moveTimeMs;
+    engineNodes = nodes;
+    engineDeadlineMs = deadlineMs;
+}
+
+bool ChessGame::updateClock(Color player, int elapsedMs, bool moveMade) {
+    if (!clockEnabled) return true;
 
+    int& timeLeft = (player == Color::WHITE) ? whiteTimeMs : blackTimeMs;
+    timeLeft -= elapsedMs;
+    if (timeLeft <= 0) {
+        timeLeft = 0;
+        gameOver = true;
+        gameResult = (player == Color::WHITE) ? "Black wins on time!" : "White wins on time!";
+        return false;
+    }
+    if (moveMade) timeLeft += incrementMs;
+    return true;
+}
+
+SearchLimits ChessGame::buildEngineLimits() const {
+    SearchLimits limits;
+    if (clockEnabled) {
+        limits.wtimeMs = whiteTimeMs;
+        limits.btimeMs = blackTimeMs;
+        limits.wincMs = limits.bincMs = incrementMs;
+    } else {
+        limits.movetimeMs = engineMoveTimeMs;
+        limits.nodes = engineNodes;
+    }
+
+    // Never let the engine think past the deadline or the time left on its clock
+    limits.deadlineMs = engineDeadlineMs;
+    if (clockEnabled) {
+        int timeLeft = (currentPlayer == Color::WHITE) ? whiteTimeMs : blackTimeMs;
+        int clockCap = std::max(1, timeLeft - 50);
+        limits.deadlineMs = (limits.deadlineMs > 0) ? std::min(limits.deadlineMs, clockCap) : clockCap;
+    }
+    return limits;
+}
+
+std::string ChessGame::requestEngineMove() {
+    if (!engine) {
+        engine = std::make_unique<UciEngine>(enginePath);
+        engine->setAnalysisCache(&AnalysisCache::shared());
+        if (!engine->start()) {
+            engine.reset();
+            return "";
+        }
+        engine->newGame();
+    }
+
+    SearchResult result;
+    if (engine->isPondering() && engine->getPonderMove() == lastMove) {
+        // The human played the expected reply: reuse the search that ran on their time
+        std::cout << "Ponder hit.\n";
+        result = engine->ponderHit(buildEngineLimits());
+    } else {
+        // A ponder miss is cancelled inside searchFEN before the new search starts
+        result = engine->searchFEN(board.getFEN(currentPlayer), buildEngineLimits());
+    }
+
+    expectedReply = result.ponderMove;
+    return result.bestMove;
+}
+
+void ChessGame::startPondering() {
+    if (!engine || expectedReply.empty() || gameOver) return;
+    engine->startPonder(board.getFEN(currentPlayer), expectedReply, buildEngineLimits());
+}
+
+std::string ChessGame::readHumanInput() {
+    std::string input;
+    if (!engine || !engine->isPondering()) {
+        std::getline(std::cin, input);
+        return input;
+    }
+
+    // The ponder search keeps writing info lines; unread, they fill the pipe (about
+    // 4 KB on Windows) and block the engine. Read the console on another thread
+    // and keep draining the engine here until the human has typed a line.
+    auto line = std::async(std::launch::async, [] {
+        std::string text;
+        std::getline(std::cin, text);
+        return text;
+    });
+    while (line.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        if (!engine->poll(PONDER_POLL_MS)) line.wait();
+    }
+    return line.get();
+}
+
+void ChessGame::showExplorer() {
+    if (!positionIndex) {
+        positionIndex = std::make_unique<PositionIndex>();
+    }
+    std::string path = PositionIndex::defaultPath();
+    if (!positionIndex->isOpen() && !positionIndex->open(path)) {
+        std::cout << "No position index at " << path << " (build one with: chess index build FILE.pgn...)\n";
+        return;
+    }
+
+    PositionStats stats;
+    if (!positionIndex->lookup(board, currentPlayer, stats)) {
+        std::cout << "No games reached this position.\n";
+        return;
+    }
+
+    auto percent = [](uint32_t part, uint32_t total) {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(0) << (total ? 100.0 * part / total : 0.0) << "%";
+        return oss.str();
+    };
+    std::cout << stats.count << " games  White " << percent(stats.whiteWins, stats.count)
+              << "  Draw " << percent(stats.draws, stats.count)
+              << "  Black " << percent(stats.blackWins, stats.count) << "\n";
+    for (const MoveStats& move : stats.moves) {
+        std::cout << "  " << std::left << std::setw(8) << board.getSAN(move.move) << std::right << std::setw(8)
+                  << move.count << "  White " << percent(move.whiteWins, move.count)
+                  << "  Draw " << percent(move.draws, move.count)
+                  << "  Black " << percent(move.blackWins, move.count) << "\n";
+    }
+}
 
 void ChessGame::startGame() {
     std::cout << "Welcome to C++ Chess Game!\n";
     std::cout << "Enter moves in algebraic notation (e.g., 'e2e4' or 'e2-e4')\n";
-    std::cout << "Type 'quit' to exit the game\n\n";
+    std::cout << "Type 'quit' to exit the game\n";
+    std::cout << "Type 'profile' to show timing statistics\n";
+    std::cout << "Type 'explore' to show how often each move was played from here\n\n";
 
     while (!gameOver) {
         board.displayBoard();
 
+        if (clockEnabled) {
+            std::cout << "White " << formatClock(whiteTimeMs)
+                      << "  Black " << formatClock(blackTimeMs) << "\n";
+        }
+
         std::string playerName = (currentPlayer == Color::WHITE) ? "White" : "Black";
         std::cout << playerName << " to move: ";
 
@@ -42,8 +210,9 @@ void ChessGame::playTurn() {
     // If CPU is enabled and it's CPU's turn, let Stockfish move
     if (isCPUEnabled && currentPlayer == cpuColor) {
         std::cout << "CPU is thinking using Stockfish...\n";
-        std::string fen = board.getFEN(currentPlayer);
-        std::string bestMoveStr = getBestMoveFromStockfish(fen);
+        auto start = std::chrono::steady_clock::now();
+        std::string bestMoveStr = requestEngineMove();
+        if (!updateClock(currentPlayer, millisecondsSince(start), true)) return;
 
         if (bestMoveStr.length() < 4 || bestMoveStr.length() > 5){
             std::cout << "Invalid move from Stockfish: " << bestMoveStr << "\n";
@@ -64,12 +233,14 @@ void ChessGame::playTurn() {
         }
 
         switchPlayer();  //switch after CPU moves
+        startPondering();
         return;
     }
 
     //Regular user move
-    std::string input;
-    std::getline(std::cin, input);
+    auto start = std::chrono::steady_clock::now();
+    std::string input = readHumanInput();
+    if (!updateClock(currentPlayer, millisecondsSince(start), false)) return;
 
     // Trim whitespace
     input.erase(input.begin(), std::find_if(input.begin(), input.end(), [](unsigned char ch) {
@@ -85,118 +256,27 @@ void ChessGame::playTurn() {
         return;
     }
 
-    if (makeMove(input)) {
-        switchPlayer();
-    } else {
-        std::cout << "Invalid move. Please try again.\n";
-    }
-}
-std::string getBestMoveFromStockfish(const std::string& fen, const std::string& stockfishPath) {
-    HANDLE hChildStd_IN_Rd = NULL;
-    HANDLE hChildStd_IN_Wr = NULL;
-    HANDLE hChildStd_OUT_Rd = NULL;
-    HANDLE hChildStd_OUT_Wr = NULL;
-
-    SECURITY_ATTRIBUTES saAttr;
-    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
-    saAttr.bInheritHandle = TRUE;
-    saAttr.lpSecurityDescriptor = NULL;
-
-    // Create a pipe for the child process's STDOUT.
-    if (!CreatePipe(&hChildStd_OUT_Rd, &hChildStd_OUT_Wr, &saAttr, 0)) {
-        std::cerr << "Stdout pipe creation failed\n";
-        return "";
-    }
-    // Ensure read handle to STDOUT is not inherited.
-    SetHandleInformation(hChildStd_OUT_Rd, HANDLE_FLAG_INHERIT, 0);
-
-    // Create a pipe for the child process's STDIN.
-    if (!CreatePipe(&hChildStd_IN_Rd, &hChildStd_IN_Wr, &saAttr, 0)) {
-        std::cerr << "Stdin pipe creation failed\n";
-        return "";
-    }
-    SetHandleInformation(hChildStd_IN_Wr, HANDLE_FLAG_INHERIT, 0);
-
-    PROCESS_INFORMATION piProcInfo;
-    ZeroMemory(&piProcInfo, sizeof(PROCESS_INFORMATION));
-
-    STARTUPINFOA siStartInfo;
-    ZeroMemory(&siStartInfo, sizeof(STARTUPINFOA));
-    siStartInfo.cb = sizeof(STARTUPINFOA);
-    siStartInfo.hStdError = hChildStd_OUT_Wr;
-    siStartInfo.hStdOutput = hChildStd_OUT_Wr;
-    siStartInfo.hStdInput = hChildStd_IN_Rd;
-    siStartInfo.dwFlags |= STARTF_USESTDHANDLES;
-
-    // Start the child process.
-    std::string cmdLine = stockfishPath;
-    BOOL success = CreateProcessA(
-        NULL,
-        &cmdLine[0],
-        NULL, NULL,
-        TRUE,
-        0,
-        NULL, NULL,
-        &siStartInfo,
-        &piProcInfo
-    );
-
-    if (!success) {
-        std::cerr << "CreateProcess failed\n";
-        return "";
+    if (input == "profile") {
+        Profiler::report(std::cout);
+        return;
     }
 
-    // Send UCI commands to Stockfish
-    std::string commands =
-        "uci\n"
-        "isready\n"
-        "ucinewgame\n"
-        "position fen " + fen + "\n"
-        "go depth 20\n";
-
-    DWORD written;
-    WriteFile(hChildStd_IN_Wr, commands.c_str(), commands.length(), &written, NULL);
-
-    // Read Stockfish output
-    char buffer[4096];
-    DWORD bytesRead;
-    std::string output;
-    while (true) {
-        BOOL result = ReadFile(hChildStd_OUT_Rd, buffer, sizeof(buffer) - 1, &bytesRead, NULL);
-        if (!result || bytesRead == 0) break;
-        buffer[bytesRead] = '\0';
-        output += buffer;
-        if (output.find("bestmove") != std::string::npos) break;
+    if (input == "explore") {
+        showExplorer();
+        return;
     }
 
-    // Cleanup
-    CloseHandle(hChildStd_IN_Wr);
-    CloseHandle(hChildStd_IN_Rd);
-    CloseHandle(hChildStd_OUT_Rd);
-    CloseHandle(hChildStd_OUT_Wr);
-    TerminateProcess(piProcInfo.hProcess, 0);
-    CloseHandle(piProcInfo.hProcess);
-    CloseHandle(piProcInfo.hThread);
-
-    // Extract best move
-    size_t pos = output.find("bestmove ");
-    if (pos != std::string::npos) {
-        size_t end = output.find('\n', pos);
-        std::string moveLine = output.substr(pos, end - pos);
-        std::istringstream iss(moveLine);
-        std::string tag, move;
-        iss >> tag >> move;
-        return move;
+    if (makeMove(input)) {
+        updateClock(currentPlayer, 0, true);
+        switchPlayer();
+    } else {
+        std::cout << "Invalid move. Please try again.\n";
     }
-
-    return "";
 }
 
-
 bool ChessGame::makeMove(const std::string& algebraicMove) {
     try {
         Move move = parseAlgebraicNotation(algebraicMove);
-        // std::cout << "Parsed move: " << move.from.toAlgebraic() << " to " << move.to.toAlgebraic() << std::endl;
         if (!move.from.isValid() || !move.to.isValid()) {
             std::cout << "Invalid move format. Use format like 'e2e4' or 'e2-e4'\n";
             return false;
@@ -207,41 +287,21 @@ bool ChessGame::makeMove(const std::string& algebraicMove) {
             std::cout << "No piece at the specified position.\n";
             return false;
         }
-        std::cout << "Piece at " << move.from.toAlgebraic() << " is " 
-          << (piece->color == Color::WHITE ? "White" : "Black") << "\n";
+        LOG_DEBUG("Piece at " << move.from.toAlgebraic() << " is "
+                  << (piece->color == Color::WHITE ? "White" : "Black"));
 
         if (piece->color != currentPlayer) {
             std::cout << "That's not your piece!\n";
             return false;
         }
 
-        // Check if the move is legal
-        auto legalMoves = board.getAllLegalMoves(currentPlayer);
-        bool isLegal = false;
-        // std::cout << "Here\n";
-        for (const auto& legalMove : legalMoves) {
-            if (legalMove.from == move.from && legalMove.to == move.to) {
-                // For pawn promotion, check if promotion piece matches
-                if (piece->type == PieceType::PAWN && 
-                    ((piece->color == Color::WHITE && move.to.row == 7) ||
-                     (piece->color == Color::BLACK && move.to.row == 0))) {
-                    if (legalMove.promotionPiece == move.promotionPiece) {
-                        isLegal = true;
-                        break;
-                    }
-                } else {
-                    isLegal = true;
-                    break;
-                }
-            }
-        }
-
-        if (!isLegal) {
+        if (!board.isLegal(move)) {
             std::cout << "Illegal move.\n";
             return false;
         }
 
         // Make the move
+        lastMove = board.getUCI(move);
         board.movePiece(move);
 
         // Check for check
@@ -266,12 +326,10 @@ Move ChessGame::parseAlgebraicNotation(const std::string& notation) const {
     if (dashPos != std::string::npos) {
         cleanNotation.erase(dashPos, 1);
     }
-    std::cout << "Parsing move: " << cleanNotation << std::endl;
     // Remove spaces
     cleanNotation.erase(std::remove(cleanNotation.begin(), cleanNotation.end(), ' '), 
                        cleanNotation.end());
 
-    std:: cout << "Cleaned notation: " << cleanNotation << std::endl;
     // Convert to lowercase for parsing
     std::transform(cleanNotation.begin(), cleanNotation.end(), cleanNotation.begin(), ::tolower);
 
@@ -287,7 +345,7 @@ Move ChessGame::parseAlgebraicNotation(const std::string& notation) const {
     // Parse to position
     std::string toStr = cleanNotation.substr(2, 2);
     Position to = Position::fromAlgebraic(toStr);
-    std:: cout << fromStr << " to " << toStr << std::endl;
+    LOG_DEBUG("Parsing move " << notation << ": " << fromStr << " to " << toStr);
     // Check for promotion
     PieceType promotionPiece = PieceType::QUEEN;  // Default promotion
     if (cleanNotation.length() >= 5) {
@@ -0,0 +1,17 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+
+// Quotes text as a JSON string, escaping quotes and backslashes. FENs, moves and
+// file names never contain control characters, so those are passed through.
+inline std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+#endif // JSON_H
@@ -0,0 +1,205 @@
+#include "log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Bytes collected before the buffer is written out
+const size_t BUFFER_LIMIT = 64 * 1024;
+// How long the async writer lets messages sit in the buffer at most
+const int ASYNC_INTERVAL_MS = 100;
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO ";
+        case LogLevel::WARN: return "WARN ";
+        case LogLevel::ERR: return "ERROR";
+        default: return "";
+    }
+}
+
+struct LogState {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::string buffer;
+    FILE* sink = stderr;
+    bool async = false;
+    bool urgent = false;            // A warning or error is waiting for the async writer
+    bool stopping = false;
+    std::thread writer;
+
+    ~LogState() {
+        stopWriter();
+        std::lock_guard<std::mutex> lock(mutex);
+        writeOut();
+        if (sink != stderr) std::fclose(sink);
+    }
+
+    // Caller holds the mutex
+    void writeOut() {
+        if (buffer.empty()) return;
+        std::fwrite(buffer.data(), 1, buffer.size(), sink);
+        std::fflush(sink);
+        buffer.clear();
+    }
+
+    void stopWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!async) return;
+            async = false;
+            stopping = true;
+            wake.notify_all();
+        }
+        writer.join();
+        stopping = false;
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wake.wait_for(lock, std::chrono::milliseconds(ASYNC_INTERVAL_MS),
+                          [this] { return stopping || urgent || buffer.size() >= BUFFER_LIMIT; });
+            urgent = false;
+            if (buffer.empty()) continue;
+
+            // Write outside the lock so logging threads only ever wait for an append
+            std::string pending;
+            pending.swap(buffer);
+            FILE* out = sink;
+            lock.unlock();
+            std::fwrite(pending.data(), 1, pending.size(), out);
+            std::fflush(out);
+            lock.lock();
+        }
+        writeOut();
+    }
+};
+
+LogState& state() {
+    static LogState logState;
+    return logState;
+}
+
+std::string formatLine(LogLevel level, const char* file, int line, const std::string& message) {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    char prefix[32];
+    std::strftime(prefix, sizeof(prefix), "%H:%M:%S", &local);
+    const char* base = std::strrchr(file, '/');
+    if (!base) base = std::strrchr(file, '\\');
+    base = base ? base + 1 : file;
+
+    char stamp[48];
+    std::snprintf(stamp, sizeof(stamp), "%s.%03d ", prefix, millis);
+    return stamp + std::string(levelName(level)) + " " + base + ":" + std::to_string(line) + " " + message + "\n";
+}
+
+} // namespace
+
+std::atomic<int> Logger::threshold(static_cast<int>(LogLevel::INFO));
+
+void Logger::setLevel(LogLevel level) {
+    threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() {
+    return static_cast<LogLevel>(threshold.load(std::memory_order_relaxed));
+}
+
+bool Logger::setFile(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "a");
+    if (!file) return false;
+
+    LogState& log = state();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.writeOut();
+    if (log.sink != stderr) std::fclose(log.sink);
+    log.sink = file;
+    return true;
+}
+
+void Logger::setAsync(bool async) {
+    LogState& log = state();
+    if (!async) {
+        log.stopWriter();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(log.mutex);
+    if (log.async) return;
+    log.async = true;
+    log.writer = std::thread(&LogState::writerLoop, &log);
+}
+
+void Logger::flush() {
+    LogState& log = state();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.writeOut();
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    static const char* names[] = {"trace", "debug", "info", "warn", "error", "off"};
+    for (int i = 0; i <= static_cast<int>(LogLevel::OFF); i++) {
+        if (name == names[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::configureFromEnvironment() {
+    if (const char* name = std::getenv("CHESS_LOG_LEVEL")) {
+        LogLevel level;
+        if (parseLevel(name, level)) {
+            setLevel(level);
+            if (static_cast<int>(level) < CHESS_LOG_MIN_LEVEL) {
+                LOG_WARN("Log level " << name << " was compiled out; rebuild with CHESS_LOG_MIN_LEVEL=" << name);
+            }
+        } else {
+            LOG_WARN("Unknown log level: " << name);
+        }
+    }
+    if (const char* path = std::getenv("CHESS_LOG_FILE")) {
+        if (!setFile(path)) LOG_ERROR("Could not open log file " << path);
+    }
+    if (const char* async = std::getenv("CHESS_LOG_ASYNC")) {
+        setAsync(std::string(async) == "1");
+    }
+}
+
+void Logger::write(LogLevel level, const char* file, int line, const std::string& message) {
+    std::string text = formatLine(level, file, line, message);
+    bool important = level >= LogLevel::WARN;
+    // Only trace and debug come in volumes worth batching; progress messages show at once
+    bool immediate = level >= LogLevel::INFO;
+
+    LogState& log = state();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.buffer += text;
+    if (log.async) {
+        if (important || log.buffer.size() >= BUFFER_LIMIT) {
+            log.urgent = log.urgent || important;
+            log.wake.notify_one();
+        }
+    } else if (immediate || log.buffer.size() >= BUFFER_LIMIT) {
+        log.writeOut();
+    }
+}
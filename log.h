@@ -0,0 +1,75 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+// Leveled logging for engine and board code. Trace and debug messages go to an
+// in-memory buffer that is written to stderr or a file in large chunks, when it
+// fills up or a message of a higher level arrives, so the verbose levels never
+// wait on the terminal. In async mode every level is buffered and a background
+// thread does the writing, at once for warnings and errors.
+//
+// Levels below CHESS_LOG_MIN_LEVEL (0 trace, 1 debug, 2 info, the default) are
+// compiled out entirely: their LOG_* macros expand to nothing and the message
+// is never formatted. Enabled levels are filtered again at runtime.
+
+// ERR rather than ERROR, which <windows.h> defines as a macro
+enum class LogLevel { TRACE, DEBUG, INFO, WARN, ERR, OFF };
+
+#ifndef CHESS_LOG_MIN_LEVEL
+    #define CHESS_LOG_MIN_LEVEL 2
+#endif
+
+class Logger {
+public:
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+
+    // Sends output to a file (appending) instead of stderr; false if it cannot be opened
+    static bool setFile(const std::string& path);
+    // Writes the buffer from a background thread instead of the logging thread
+    static void setAsync(bool async);
+    static void flush();
+
+    // Applies CHESS_LOG_LEVEL (trace, debug, info, warn, error, off),
+    // CHESS_LOG_FILE and CHESS_LOG_ASYNC=1 from the environment
+    static void configureFromEnvironment();
+    static bool parseLevel(const std::string& name, LogLevel& level);
+
+    static void write(LogLevel level, const char* file, int line, const std::string& message);
+
+private:
+    static std::atomic<int> threshold;
+};
+
+#define LOG_AT(level, message)                                                   \
+    do {                                                                         \
+        if (Logger::enabled(level)) {                                            \
+            std::ostringstream logStream_;                                       \
+            logStream_ << message;                                               \
+            Logger::write(level, __FILE__, __LINE__, logStream_.str());          \
+        }                                                                        \
+    } while (0)
+
+#if CHESS_LOG_MIN_LEVEL <= 0
+    #define LOG_TRACE(message) LOG_AT(LogLevel::TRACE, message)
+#else
+    #define LOG_TRACE(message) ((void)0)
+#endif
+
+#if CHESS_LOG_MIN_LEVEL <= 1
+    #define LOG_DEBUG(message) LOG_AT(LogLevel::DEBUG, message)
+#else
+    #define LOG_DEBUG(message) ((void)0)
+#endif
+
+#define LOG_INFO(message) LOG_AT(LogLevel::INFO, message)
+#define LOG_WARN(message) LOG_AT(LogLevel::WARN, message)
+#define LOG_ERROR(message) LOG_AT(LogLevel::ERR, message)
+
+#endif // LOG_H
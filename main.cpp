@@ -1,13 +1,79 @@
 #include "chess.h"
+#include "tournament.h"
+#include "engine_pool.h"
+#include "analysis.h"
+#include "position_index.h"
+#include "mate_solver.h"
+#include "training_data.h"
+#include "uci_frontend.h"
+#include "profiler.h"
+#include "log.h"
+#include <csignal>
 #include <iostream>
 #include <string>
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        Logger::configureFromEnvironment();
+#ifndef _WIN32
+        // A dead engine must not take the whole program down on the next write to its pipe
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+        // Instrumentation report on exit, when built with -DCHESS_PROFILE
+        if (const char* profilePath = std::getenv("CHESS_PROFILE_REPORT")) {
+            Profiler::dumpOnExit(profilePath);
+        }
+
+        if (argc > 1 && std::string(argv[1]) == "tournament") {
+            return runTournamentCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "analyze") {
+            return runAnalyzeCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "multipv") {
+            return runMultiPVCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "index") {
+            return runIndexCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "mate") {
+            return runMateCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "datagen") {
+            return runDatagenCommand(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "uci") {
+            return runUciCommand(argc, argv);
+        }
+
         std::string mode;
         std::cout << "Choose mode: [1] Player vs Player, [2] Player vs CPU: ";
         std::getline(std::cin, mode);
 
+        // A GUI that starts the program without arguments opens with "uci".
+        // End the prompt line so the GUI sees the replies on lines of their own.
+        if (mode == "uci" || mode == "uci\r") {
+            std::cout << std::endl;
+            UciFrontend frontend(std::cout);
+            frontend.handleCommand("uci");
+            frontend.run(std::cin);
+            return 0;
+        }
+
+        // Optional clock, e.g. "5+3" for five minutes plus three seconds per move
+        std::string timeControl;
+        std::cout << "Time control in minutes+increment (leave empty for none): ";
+        std::getline(std::cin, timeControl);
+        int baseMs = 0, incrementMs = 0;
+        if (!timeControl.empty()) {
+            size_t plus = timeControl.find('+');
+            baseMs = static_cast<int>(std::atof(timeControl.substr(0, plus).c_str()) * 60000);
+            if (plus != std::string::npos) {
+                incrementMs = static_cast<int>(std::atof(timeControl.substr(plus + 1).c_str()) * 1000);
+            }
+        }
+
         if (mode == "2") {
             std::string color;
             std::cout << "Should CPU play as white or black? [w/b]: ";
@@ -15,9 +81,11 @@ int main() {
 
             Color cpuColor = (color == "w" || color == "W") ? Color::WHITE : Color::BLACK;
             ChessGame game(true, cpuColor);  // Enable CPU mode
+            game.setTimeControl(baseMs, incrementMs);
             game.startGame();
         } else {
             ChessGame game(false);  // Player vs Player
+            game.setTimeControl(baseMs, incrementMs);
             game.startGame();
         }
     } catch (const std::exception& e) {
@@ -0,0 +1,353 @@
+#include "mate_solver.h"
+#include "json.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Proof and disproof numbers saturate here; a node at INFINITE is settled
+const uint32_t INFINITE = 1u << 30;
+
+uint32_t addSaturated(uint32_t a, uint32_t b) {
+    return std::min(INFINITE, a + b);
+}
+
+} // namespace
+
+const size_t MateSolver::DEFAULT_HASH_MB;
+
+MateSolver::MateSolver(size_t hashMb) : attacker(Color::WHITE), checksOnly(true), nodes(0), nodeLimit(0) {
+    // Largest power of two that fits, so the key can be masked into an index
+    size_t entries = 1;
+    while (entries * 2 * sizeof(Entry) <= std::max<size_t>(hashMb, 1) * 1024 * 1024) entries *= 2;
+    table.resize(entries);
+}
+
+void MateSolver::clear() {
+    std::fill(table.begin(), table.end(), Entry());
+}
+
+uint64_t MateSolver::nodeKey(const ChessBoard& board, Color sideToMove, int plies) const {
+    // Mixed in so the same position with a different number of plies left is a different node
+    return board.getHash(sideToMove) ^ (static_cast<uint64_t>(plies + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+void MateSolver::lookup(uint64_t key, uint32_t& proof, uint32_t& disproof) const {
+    const Entry& entry = table[key & (table.size() - 1)];
+    if (entry.key == key) {
+        proof = entry.proof;
+        disproof = entry.disproof;
+    } else {
+        proof = disproof = 1;
+    }
+}
+
+void MateSolver::store(uint64_t key, uint32_t proof, uint32_t disproof) {
+    Entry& entry = table[key & (table.size() - 1)];
+    entry.key = key;
+    entry.proof = proof;
+    entry.disproof = disproof;
+}
+
+std::vector<Move> MateSolver::nodeMoves(const ChessBoard& board, Color sideToMove) const {
+    std::vector<Move> moves = board.getAllLegalMoves(sideToMove);
+    if (sideToMove != attacker || !checksOnly) return moves;
+
+    std::vector<Move> checks;
+    for (const Move& move : moves) {
+        ChessBoard child = board;
+        child.movePiece(move);
+        if (child.isInCheck(opposite(sideToMove))) checks.push_back(move);
+    }
+    return checks;
+}
+
+MateResult MateSolver::solve(const ChessBoard& board, Color attacker, int maxMoves, long long nodeBudget,
+                             bool checksOnly) {
+    this->attacker = attacker;
+    this->checksOnly = checksOnly;
+    nodes = 0;
+    nodeLimit = (nodeBudget > 0) ? nodeBudget : LLONG_MAX;
+
+    MateResult result;
+    for (int moves = 1; moves <= maxMoves; moves++) {
+        int plies = 2 * moves - 1;
+        search(board, attacker, plies, INFINITE, INFINITE);
+
+        uint32_t proof, disproof;
+        lookup(nodeKey(board, attacker, plies), proof, disproof);
+        if (proof == 0) {
+            result.status = MateResult::Status::MATE;
+            result.mateIn = moves;
+            // The proof tree is mostly in the table, so the line is cheap to read back
+            nodeLimit = LLONG_MAX;
+            result.line = extractLine(board, plies);
+            break;
+        }
+        if (disproof != 0) {
+            result.status = MateResult::Status::BUDGET;
+            break;
+        }
+    }
+    result.nodes = nodes;
+    return result;
+}
+
+void MateSolver::search(const ChessBoard& board, Color sideToMove, int plies, uint32_t proofLimit,
+                        uint32_t disproofLimit) {
+    nodes++;
+    uint64_t key = nodeKey(board, sideToMove, plies);
+    bool attackerToMove = sideToMove == attacker;
+
+    std::vector<Move> moves = nodeMoves(board, sideToMove);
+    if (!attackerToMove && moves.empty()) {
+        // Mated, or stalemated
+        bool mated = board.isInCheck(sideToMove);
+        store(key, mated ? 0 : INFINITE, mated ? INFINITE : 0);
+        return;
+    }
+    if (moves.empty() || plies == 0) {
+        store(key, INFINITE, 0);
+        return;
+    }
+
+    std::vector<Child> children;
+    children.reserve(moves.size());
+    for (const Move& move : moves) {
+        Child child{move, board, 0};
+        child.board.movePiece(move);
+        child.key = nodeKey(child.board, opposite(sideToMove), plies - 1);
+        children.push_back(std::move(child));
+    }
+
+    while (true) {
+        // OR node: proved by any child, disproved only by all. AND node: the reverse.
+        uint32_t proof = attackerToMove ? INFINITE : 0;
+        uint32_t disproof = attackerToMove ? 0 : INFINITE;
+        size_t best = 0;
+        uint32_t bestValue = INFINITE + 1, secondValue = INFINITE;
+        uint32_t bestProof = 0, bestDisproof = 0;
+        for (size_t i = 0; i < children.size(); i++) {
+            uint32_t childProof, childDisproof;
+            lookup(children[i].key, childProof, childDisproof);
+            uint32_t value = attackerToMove ? childProof : childDisproof;
+            if (attackerToMove) {
+                proof = std::min(proof, childProof);
+                disproof = addSaturated(disproof, childDisproof);
+            } else {
+                proof = addSaturated(proof, childProof);
+                disproof = std::min(disproof, childDisproof);
+            }
+            if (value < bestValue) {
+                secondValue = bestValue;
+                bestValue = value;
+                best = i;
+                bestProof = childProof;
+                bestDisproof = childDisproof;
+            } else if (value < secondValue) {
+                secondValue = value;
+            }
+        }
+        store(key, proof, disproof);
+        if (proof >= proofLimit || disproof >= disproofLimit || nodes >= nodeLimit) return;
+
+        // Descend into the most-proving child until it stops being the best one
+        // or the whole node reaches its limits
+        uint32_t childProofLimit, childDisproofLimit;
+        if (attackerToMove) {
+            childProofLimit = std::min(proofLimit, addSaturated(secondValue, 1));
+            childDisproofLimit = (disproofLimit >= INFINITE) ? INFINITE : disproofLimit - disproof + bestDisproof;
+        } else {
+            childDisproofLimit = std::min(disproofLimit, addSaturated(secondValue, 1));
+            childProofLimit = (proofLimit >= INFINITE) ? INFINITE : proofLimit - proof + bestProof;
+        }
+        search(children[best].board, opposite(sideToMove), plies - 1, childProofLimit, childDisproofLimit);
+    }
+}
+
+bool MateSolver::isProved(const ChessBoard& board, Color sideToMove, int plies) {
+    uint32_t proof, disproof;
+    lookup(nodeKey(board, sideToMove, plies), proof, disproof);
+    if (proof != 0 && disproof != 0) {
+        // Overwritten in the table since it was proved, or never searched
+        search(board, sideToMove, plies, INFINITE, INFINITE);
+        lookup(nodeKey(board, sideToMove, plies), proof, disproof);
+    }
+    return proof == 0;
+}
+
+std::vector<Move> MateSolver::extractLine(const ChessBoard& root, int plies) {
+    std::vector<Move> line;
+    ChessBoard board = root;
+    Color sideToMove = attacker;
+
+    while (plies > 0) {
+        bool found = false;
+        if (sideToMove == attacker) {
+            // Any move that still mates in time
+            for (const Move& move : nodeMoves(board, sideToMove)) {
+                ChessBoard child = board;
+                child.movePiece(move);
+                if (isProved(child, opposite(sideToMove), plies - 1)) {
+                    line.push_back(move);
+                    board = child;
+                    plies--;
+                    found = true;
+                    break;
+                }
+            }
+        } else {
+            // The reply that delays mate longest
+            int longest = -1;
+            Move reply = Move(Position(), Position());
+            for (const Move& move : nodeMoves(board, sideToMove)) {
+                ChessBoard child = board;
+                child.movePiece(move);
+                int shortest = 1;
+                while (shortest < plies && !isProved(child, attacker, shortest)) shortest += 2;
+                if (shortest > longest) {
+                    longest = shortest;
+                    reply = move;
+                    found = true;
+                }
+            }
+            if (found) {
+                line.push_back(reply);
+                board.movePiece(reply);
+                plies = longest;
+            }
+        }
+        if (!found) break;
+        sideToMove = opposite(sideToMove);
+    }
+    return line;
+}
+
+int runMateCommand(int argc, char* argv[]) {
+    std::string fen;
+    std::string inputFile;
+    int maxMoves = 5;
+    long long nodeBudget = 1000000;
+    int threads = 1;
+    size_t hashMb = MateSolver::DEFAULT_HASH_MB;
+    bool checksOnly = true;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--fen" && hasValue) {
+            fen = argv[++i];
+        } else if (arg == "--input" && hasValue) {
+            inputFile = argv[++i];
+        } else if (arg == "--moves" && hasValue) {
+            maxMoves = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            nodeBudget = std::atoll(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--hash" && hasValue) {
+            hashMb = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--all-moves") {
+            checksOnly = false;
+        } else {
+            std::cerr << "Unknown mate option: " << arg << "\n"
+                      << "Usage: chess mate [--fen FEN] [--input FILE] [--moves N] [--nodes N]\n"
+                      << "       [--threads N] [--hash MB] [--all-moves]\n"
+                      << "Without --fen, puzzles are read one FEN per line from --input or standard input.\n";
+            return 1;
+        }
+    }
+    if (maxMoves <= 0 || threads <= 0) {
+        std::cerr << "Moves and threads must be positive\n";
+        return 1;
+    }
+
+    std::vector<std::string> puzzles;
+    if (!fen.empty()) {
+        puzzles.push_back(fen);
+    } else {
+        std::ifstream inFile;
+        if (!inputFile.empty()) {
+            inFile.open(inputFile);
+            if (!inFile) {
+                std::cerr << "Could not open " << inputFile << "\n";
+                return 1;
+            }
+        }
+        std::istream& in = inputFile.empty() ? std::cin : inFile;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            puzzles.push_back(line);
+        }
+    }
+
+    // Each thread has its own solver and table; results are printed in input order
+    std::vector<std::string> results(puzzles.size());
+    std::vector<bool> done(puzzles.size(), false);
+    std::atomic<size_t> nextPuzzle(0);
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        MateSolver solver(hashMb);
+        for (size_t i = nextPuzzle++; i < puzzles.size(); i = nextPuzzle++) {
+            std::string json = "{\"fen\":" + jsonString(puzzles[i]);
+            ChessBoard board;
+            Color sideToMove;
+            if (!board.setFromFEN(puzzles[i], sideToMove)) {
+                json += ",\"error\":\"invalid FEN\"}";
+            } else {
+                auto puzzleStart = std::chrono::steady_clock::now();
+                MateResult result = solver.solve(board, sideToMove, maxMoves, nodeBudget, checksOnly);
+                int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - puzzleStart).count());
+
+                if (result.status == MateResult::Status::MATE) {
+                    json += ",\"status\":\"mate\",\"mate\":" + std::to_string(result.mateIn) + ",\"line\":[";
+                    ChessBoard replay = board;
+                    for (size_t m = 0; m < result.line.size(); m++) {
+                        json += (m ? "," : "") + jsonString(replay.getUCI(result.line[m]));
+                        replay.movePiece(result.line[m]);
+                    }
+                    json += "]";
+                } else if (result.status == MateResult::Status::NO_MATE) {
+                    // Without --all-moves only mates made of checks were ruled out
+                    json += checksOnly ? ",\"status\":\"no_check_mate\"" : ",\"status\":\"none\"";
+                } else {
+                    json += ",\"status\":\"budget\"";
+                }
+                json += ",\"nodes\":" + std::to_string(result.nodes) + ",\"ms\":" + std::to_string(ms) + "}";
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[i] = json;
+            done[i] = true;
+            resultReady.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        std::unique_lock<std::mutex> lock(mutex);
+        resultReady.wait(lock, [&] { return done[i]; });
+        std::cout << results[i] << std::endl;
+    }
+    for (auto& thread : pool) thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Solved " << puzzles.size() << " puzzles in " << seconds << " s ("
+              << (seconds > 0 ? puzzles.size() / seconds : 0.0) << " puzzles/s)\n";
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef MATE_SOLVER_H
+#define MATE_SOLVER_H
+
+#include "chess.h"
+#include <cstdint>
+#include <vector>
+
+struct MateResult {
+    enum class Status { MATE, NO_MATE, BUDGET };
+
+    Status status = Status::NO_MATE;
+    int mateIn = 0;                 // Moves by the attacker, when status is MATE
+    std::vector<Move> line;         // Mating line from the root, defender resisting longest
+    long long nodes = 0;
+};
+
+// Finds forced mates with depth-first proof-number search (df-pn).
+//
+// The side to move is the attacker. Attacker nodes are OR nodes (one move that
+// mates is enough) and defender nodes are AND nodes (every reply must be
+// mated); each node carries a proof number and a disproof number, the minimum
+// number of leaves still to be proved or disproved, and the search always
+// expands the most-proving node. Mate lengths 1..maxMoves are tried in turn, so
+// the first proof found is the shortest mate. The remaining plies are part of
+// the transposition key, so a position proved with more plies to spare is never
+// mistaken for one with fewer, and repetitions cannot cycle.
+class MateSolver {
+public:
+    static const size_t DEFAULT_HASH_MB = 16;
+
+    explicit MateSolver(size_t hashMb = DEFAULT_HASH_MB);
+
+    // Only checking moves are tried for the attacker unless checksOnly is false,
+    // which also finds mates that start with a quiet move but is much slower.
+    // NO_MATE means no mate within maxMoves exists (among the moves tried).
+    MateResult solve(const ChessBoard& board, Color attacker, int maxMoves, long long nodeBudget,
+                     bool checksOnly = true);
+
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t proof = 0;
+        uint32_t disproof = 0;
+    };
+
+    struct Child {
+        Move move;
+        ChessBoard board;
+        uint64_t key;
+    };
+
+    void search(const ChessBoard& board, Color sideToMove, int plies, uint32_t proofLimit, uint32_t disproofLimit);
+    // Legal moves of the node; checking moves only at attacker nodes
+    std::vector<Move> nodeMoves(const ChessBoard& board, Color sideToMove) const;
+    // Whether the node is a proved mate in at most plies, searching it if need be
+    bool isProved(const ChessBoard& board, Color sideToMove, int plies);
+    std::vector<Move> extractLine(const ChessBoard& board, int plies);
+
+    uint64_t nodeKey(const ChessBoard& board, Color sideToMove, int plies) const;
+    void lookup(uint64_t key, uint32_t& proof, uint32_t& disproof) const;
+    void store(uint64_t key, uint32_t proof, uint32_t disproof);
+
+    std::vector<Entry> table;
+    Color attacker;
+    bool checksOnly;
+    long long nodes;
+    long long nodeLimit;
+};
+
+// Entry point for "chess mate [options]"
+int runMateCommand(int argc, char* argv[]);
+
+#endif // MATE_SOLVER_H
@@ -0,0 +1,247 @@
+#include "move_ordering.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Indexed by PieceType; the king only ever attacks, so it is the "cheapest" last resort
+const int orderingValues[6] = {100, 500, 320, 330, 900, 1000};
+
+int squareIndex(const Position& pos) {
+    return pos.row * 8 + pos.col;
+}
+
+int sideIndex(Color side) {
+    return (side == Color::WHITE) ? 0 : 1;
+}
+
+} // namespace
+
+const int MoveOrdering::MAX_PLY;
+const int MoveOrdering::HISTORY_LIMIT;
+
+uint16_t packMove(const Move& move) {
+    return static_cast<uint16_t>(squareIndex(move.from) | (squareIndex(move.to) << 6) |
+                                 (static_cast<int>(move.promotionPiece) << 12));
+}
+
+Move unpackMove(uint16_t packed) {
+    Position from((packed & 63) / 8, (packed & 63) % 8);
+    Position to(((packed >> 6) & 63) / 8, ((packed >> 6) & 63) % 8);
+    return Move(from, to, static_cast<PieceType>((packed >> 12) & 7));
+}
+
+MoveOrdering::MoveOrdering() {
+    clear();
+}
+
+void MoveOrdering::clear() {
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+    std::memset(countermoves, 0, sizeof(countermoves));
+}
+
+void MoveOrdering::newSearch() {
+    std::memset(killers, 0, sizeof(killers));
+    for (auto& side : history) {
+        for (auto& from : side) {
+            for (int& score : from) score /= 2;
+        }
+    }
+}
+
+void MoveOrdering::recordCutoff(Color side, const Move& move, int depth, int ply, const Move* previousMove,
+                                const std::vector<Move>& failedQuiets) {
+    uint16_t packed = packMove(move);
+    if (ply < MAX_PLY && killers[ply][0] != packed) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = packed;
+    }
+    if (previousMove) {
+        countermoves[squareIndex(previousMove->from)][squareIndex(previousMove->to)] = packed;
+    }
+
+    // Gravity update: scores saturate towards the limit instead of overflowing
+    int bonus = std::min(depth * depth, 400);
+    auto update = [this, side](const Move& m, int delta) {
+        int& score = history[sideIndex(side)][squareIndex(m.from)][squareIndex(m.to)];
+        score += delta * 32 - score * std::abs(delta) / (HISTORY_LIMIT / 32);
+    };
+    update(move, bonus);
+    for (const Move& failed : failedQuiets) {
+        update(failed, -bonus);
+    }
+}
+
+uint16_t MoveOrdering::getKiller(int ply, int slot) const {
+    return (ply < MAX_PLY) ? killers[ply][slot] : 0;
+}
+
+uint16_t MoveOrdering::getCountermove(const Move* previousMove) const {
+    if (!previousMove) return 0;
+    return countermoves[squareIndex(previousMove->from)][squareIndex(previousMove->to)];
+}
+
+int MoveOrdering::getHistory(Color side, const Move& move) const {
+    return history[sideIndex(side)][squareIndex(move.from)][squareIndex(move.to)];
+}
+
+bool MoveOrdering::isTactical(const ChessBoard& board, const Move& move) {
+    Piece* mover = board.getPiece(move.from);
+    if (!mover) return false;
+    Piece* victim = board.getPiece(move.to);
+    if (victim && victim->color != mover->color) return true;
+    if (mover->type != PieceType::PAWN) return false;
+
+    // En passant lands on an empty square diagonally; under-promotions count as quiet
+    if (move.from.col != move.to.col) return true;
+    return (move.to.row == 0 || move.to.row == 7) && move.promotionPiece == PieceType::QUEEN;
+}
+
+int MoveOrdering::mvvLva(const ChessBoard& board, const Move& move) {
+    Piece* mover = board.getPiece(move.from);
+    if (!mover) return 0;
+    Piece* victim = board.getPiece(move.to);
+
+    int score = 0;
+    if (victim) {
+        score = 10 * orderingValues[static_cast<int>(victim->type)];
+    } else if (mover->type == PieceType::PAWN && move.from.col != move.to.col) {
+        score = 10 * orderingValues[static_cast<int>(PieceType::PAWN)];
+    }
+    if (mover->type == PieceType::PAWN && (move.to.row == 0 || move.to.row == 7)) {
+        score += 10 * (orderingValues[static_cast<int>(move.promotionPiece)] -
+                       orderingValues[static_cast<int>(PieceType::PAWN)]);
+    }
+    return score - orderingValues[static_cast<int>(mover->type)];
+}
+
+MovePicker::MovePicker(const ChessBoard& board, Color sideToMove, const std::vector<Move>& moves,
+                       const MoveOrdering& ordering, int ply, uint16_t hashMove, const Move* previousMove)
+    : board(board), sideToMove(sideToMove), moves(moves), ordering(ordering), ply(ply), hashMove(hashMove),
+      refutationIndex(0), stage(Stage::HASH_MOVE), capturesOnly(false), quietsScored(false), lastQuiet(false) {
+    refutations[0] = ordering.getKiller(ply, 0);
+    refutations[1] = ordering.getKiller(ply, 1);
+    refutations[2] = ordering.getCountermove(previousMove);
+}
+
+MovePicker::MovePicker(const ChessBoard& board, Color sideToMove, const std::vector<Move>& moves,
+                       const MoveOrdering& ordering)
+    : MovePicker(board, sideToMove, moves, ordering, MoveOrdering::MAX_PLY, 0, nullptr) {
+    capturesOnly = true;
+}
+
+bool MovePicker::next(Move& move) {
+    while (true) {
+        switch (stage) {
+            case Stage::HASH_MOVE:
+                stage = Stage::PARTITION;
+                if (hashMove) {
+                    for (const Move& candidate : moves) {
+                        if (packMove(candidate) == hashMove) {
+                            move = candidate;
+                            lastQuiet = !MoveOrdering::isTactical(board, candidate);
+                            return true;
+                        }
+                    }
+                }
+                break;
+
+            case Stage::PARTITION:
+                // Only after the hash move, which often cuts off before any exchange is evaluated
+                partition();
+                stage = Stage::CAPTURES;
+                break;
+
+            case Stage::CAPTURES:
+                if (!captures.empty()) {
+                    move = moves[takeBest(captures)];
+                    lastQuiet = false;
+                    return true;
+                }
+                stage = capturesOnly ? Stage::DONE : Stage::KILLERS;
+                break;
+
+            case Stage::KILLERS:
+                while (refutationIndex < 3) {
+                    uint16_t refutation = refutations[refutationIndex++];
+                    if (!refutation || refutation == hashMove) continue;
+                    // Skip a countermove that is also a killer
+                    bool repeated = false;
+                    for (int i = 0; i < refutationIndex - 1; i++) repeated = repeated || refutations[i] == refutation;
+                    if (repeated) continue;
+
+                    // Only legal quiet moves of this node qualify
+                    for (size_t i = 0; i < quiets.size(); i++) {
+                        if (packMove(moves[quiets[i].index]) == refutation) {
+                            move = moves[quiets[i].index];
+                            quiets[i] = quiets.back();
+                            quiets.pop_back();
+                            lastQuiet = true;
+                            return true;
+                        }
+                    }
+                }
+                stage = Stage::QUIETS;
+                break;
+
+            case Stage::QUIETS:
+                if (!quietsScored) {
+                    for (auto& quiet : quiets) quiet.score = ordering.getHistory(sideToMove, moves[quiet.index]);
+                    quietsScored = true;
+                }
+                if (!quiets.empty()) {
+                    move = moves[takeBest(quiets)];
+                    lastQuiet = true;
+                    return true;
+                }
+                stage = Stage::BAD_CAPTURES;
+                break;
+
+            case Stage::BAD_CAPTURES:
+                if (!badCaptures.empty()) {
+                    move = moves[takeBest(badCaptures)];
+                    lastQuiet = false;
+                    return true;
+                }
+                stage = Stage::DONE;
+                break;
+
+            case Stage::DONE:
+                return false;
+        }
+    }
+}
+
+void MovePicker::partition() {
+    captures.reserve(moves.size());
+    quiets.reserve(moves.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        if (hashMove && packMove(moves[i]) == hashMove) continue;
+        if (MoveOrdering::isTactical(board, moves[i])) {
+            // Taking a piece worth at least the attacker never loses material, so SEE is
+            // only needed for the rest
+            Piece* mover = board.getPiece(moves[i].from);
+            Piece* victim = board.getPiece(moves[i].to);
+            bool safe = victim && orderingValues[static_cast<int>(victim->type)] >=
+                                  orderingValues[static_cast<int>(mover->type)];
+            bool losing = !safe && board.staticExchange(moves[i]) < 0;
+            int score = MoveOrdering::mvvLva(board, moves[i]);
+            (losing ? badCaptures : captures).push_back(ScoredMove{static_cast<int>(i), score});
+        } else {
+            quiets.push_back(ScoredMove{static_cast<int>(i), 0});
+        }
+    }
+}
+
+int MovePicker::takeBest(std::vector<ScoredMove>& list) {
+    size_t best = 0;
+    for (size_t i = 1; i < list.size(); i++) {
+        if (list[i].score > list[best].score) best = i;
+    }
+    int index = list[best].index;
+    list[best] = list.back();
+    list.pop_back();
+    return index;
+}
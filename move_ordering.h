@@ -0,0 +1,100 @@
+#ifndef MOVE_ORDERING_H
+#define MOVE_ORDERING_H
+
+#include "chess.h"
+#include <cstdint>
+#include <vector>
+
+// Moves packed into 16 bits (from, to, promotion piece) for the ordering tables.
+// No legal move packs to 0, so 0 means "no move".
+uint16_t packMove(const Move& move);
+Move unpackMove(uint16_t packed);
+
+// Heuristics learned during a search that predict which moves cause cutoffs.
+// Killers are quiet moves that refuted a sibling at the same ply, history
+// counts cutoffs per (side, from, to) across the whole tree, and the
+// countermove table remembers the quiet reply that refuted a given move.
+class MoveOrdering {
+public:
+    static const int MAX_PLY = 128;
+
+    MoveOrdering();
+
+    // Forgets everything, e.g. between games
+    void clear();
+    // Keeps history as a hint for the next search but lets new cutoffs dominate
+    void newSearch();
+
+    // Credits the quiet move that caused a beta cutoff and penalises the quiet
+    // moves searched before it without success
+    void recordCutoff(Color side, const Move& move, int depth, int ply, const Move* previousMove,
+                      const std::vector<Move>& failedQuiets);
+
+    uint16_t getKiller(int ply, int slot) const;
+    uint16_t getCountermove(const Move* previousMove) const;
+    int getHistory(Color side, const Move& move) const;
+
+    // Most valuable victim, least valuable attacker; also scores promotions
+    static int mvvLva(const ChessBoard& board, const Move& move);
+    // Captures (including en passant) and promotions
+    static bool isTactical(const ChessBoard& board, const Move& move);
+
+private:
+    static const int HISTORY_LIMIT = 1 << 20;
+
+    uint16_t killers[MAX_PLY][2];
+    int history[2][64][64];
+    uint16_t countermoves[64][64];      // Indexed by the previous move's from and to squares
+};
+
+// Hands out the legal moves of a node in stages, best first, without sorting
+// the whole list: the hash move, winning and equal captures and promotions by
+// MVV-LVA, killer moves and the countermove, the remaining quiet moves by
+// history, and finally captures that lose material by static exchange. Each
+// stage is scored only when it is reached, so a cutoff on the hash move or a
+// capture never pays for scoring the quiet moves.
+class MovePicker {
+public:
+    MovePicker(const ChessBoard& board, Color sideToMove, const std::vector<Move>& moves,
+               const MoveOrdering& ordering, int ply, uint16_t hashMove, const Move* previousMove);
+    // Quiescence: only the winning and equal captures and promotions, best first
+    MovePicker(const ChessBoard& board, Color sideToMove, const std::vector<Move>& moves,
+               const MoveOrdering& ordering);
+
+    bool next(Move& move);
+    // Whether the move last returned by next() is quiet (not a capture or promotion)
+    bool lastWasQuiet() const { return lastQuiet; }
+
+private:
+    enum class Stage { HASH_MOVE, PARTITION, CAPTURES, KILLERS, QUIETS, BAD_CAPTURES, DONE };
+
+    struct ScoredMove {
+        int index;
+        int score;
+    };
+
+    // Splits the moves other than the hash move into captures (by MVV-LVA, or
+    // static exchange where that is needed), quiets and bad captures
+    void partition();
+    // Removes and returns the highest scored entry
+    static int takeBest(std::vector<ScoredMove>& list);
+
+    const ChessBoard& board;
+    Color sideToMove;
+    const std::vector<Move>& moves;
+    const MoveOrdering& ordering;
+    int ply;
+    uint16_t hashMove;
+    uint16_t refutations[3];            // Two killers and the countermove
+    int refutationIndex;
+
+    Stage stage;
+    bool capturesOnly;
+    std::vector<ScoredMove> captures;
+    std::vector<ScoredMove> badCaptures;
+    std::vector<ScoredMove> quiets;
+    bool quietsScored;
+    bool lastQuiet;
+};
+
+#endif // MOVE_ORDERING_H
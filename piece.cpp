@@ -16,6 +16,22 @@ std::string Position::toAlgebraic() const{
     return result;
 }
 
+Move Move::fromUCI(const std::string& uci){
+    if (uci.length() < 4) return Move(Position(-1,-1), Position(-1,-1));
+    Position from = Position::fromAlgebraic(uci.substr(0, 2));
+    Position to = Position::fromAlgebraic(uci.substr(2, 2));
+    PieceType promotionPiece = PieceType::QUEEN;
+    if (uci.length() >= 5) {
+        switch (uci[4]) {
+            case 'r': promotionPiece = PieceType::ROOK; break;
+            case 'b': promotionPiece = PieceType::BISHOP; break;
+            case 'n': promotionPiece = PieceType::KNIGHT; break;
+            default: promotionPiece = PieceType::QUEEN; break;
+        }
+    }
+    return Move(from, to, promotionPiece);
+}
+
 // Helper function to add moves in a direction
 std::vector<Move> addDirectionalMoves(const Position& pos, ChessBoard& board, int rowDir, int colDir, int maxSteps = 8){
     std::vector<Move> moves;
@@ -45,7 +61,6 @@ std::vector<Move> addDirectionalMoves(const Position& pos, ChessBoard& board, in
 // Pawn implementation
 std::vector<Move> Pawn::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached Pawn Start\n";
     int direction = (color == Color::WHITE) ? 1 : -1;
     int startRow = (color == Color::WHITE) ? 1 : 6;
     int promotionRow = (color == Color::WHITE) ? 7 : 0;
@@ -94,14 +109,12 @@ std::vector<Move> Pawn::getPossibleMoves(const Position& pos, ChessBoard& board)
             }
         }
     }
-    // std::cout << "Reached Pawn End\n";
     return moves;
 }
 
 // Rook implementation
 std::vector<Move> Rook::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached Rook Start\n";
     // Horizontal and vertical directions
     int directions[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
 
@@ -109,7 +122,6 @@ std::vector<Move> Rook::getPossibleMoves(const Position& pos, ChessBoard& board)
         auto dirMoves = addDirectionalMoves(pos, board, dir[0], dir[1]);
         moves.insert(moves.end(), dirMoves.begin(), dirMoves.end());
     }
-    // std::cout << "Reached Rook End\n";
 
     return moves;
 }
@@ -117,7 +129,6 @@ std::vector<Move> Rook::getPossibleMoves(const Position& pos, ChessBoard& board)
 // Knight implementation
 std::vector<Move> Knight::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached Knight Start\n";
     // Knight moves: 8 possible L-shaped moves
     int knightMoves[8][2] = {
         {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
@@ -134,14 +145,12 @@ std::vector<Move> Knight::getPossibleMoves(const Position& pos, ChessBoard& boar
             }
         }
     }
-    // std::cout << "Reached Knight End\n";
     return moves;
 }
 
 // Bishop implementation
 std::vector<Move> Bishop::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached Bishop Start\n";
     // Diagonal directions
     int directions[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
 
@@ -149,14 +158,12 @@ std::vector<Move> Bishop::getPossibleMoves(const Position& pos, ChessBoard& boar
         auto dirMoves = addDirectionalMoves(pos, board, dir[0], dir[1]);
         moves.insert(moves.end(), dirMoves.begin(), dirMoves.end());
     }
-    // std::cout << "Reached Bishop End\n";
     return moves;
 }
 
 // Queen implementation
 std::vector<Move> Queen::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached Queen Start\n";
     // Queen moves like both rook and bishop
     int directions[8][2] = {
         {0, 1}, {0, -1}, {1, 0}, {-1, 0},    // Rook moves
@@ -167,14 +174,12 @@ std::vector<Move> Queen::getPossibleMoves(const Position& pos, ChessBoard& board
         auto dirMoves = addDirectionalMoves(pos, board, dir[0], dir[1]);
         moves.insert(moves.end(), dirMoves.begin(), dirMoves.end());
     }
-    // std::cout << "Reached Queen End\n";
     return moves;
 }
 
 // King implementation
 std::vector<Move> King::getPossibleMoves(const Position& pos, ChessBoard& board) const {
     std::vector<Move> moves;
-    // std::cout << "Reached King Start\n";
     // King moves: one square in any direction
     int directions[8][2] = {
         {0, 1}, {0, -1}, {1, 0}, {-1, 0},
@@ -199,7 +204,6 @@ std::vector<Move> King::getPossibleMoves(const Position& pos, ChessBoard& board)
             Position kingSidePos(pos.row, pos.col + 2);
             moves.emplace_back(pos, kingSidePos);
         }
-        std::cout << "King Here\n";
 
         // Queen-side castling
         if (board.canCastle(color, false)) {
@@ -207,6 +211,5 @@ std::vector<Move> King::getPossibleMoves(const Position& pos, ChessBoard& board)
             moves.emplace_back(pos, queenSidePos);
         }
     }
-    // std::cout << "Reached King End\n";
     return moves;
 }
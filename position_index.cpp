@@ -0,0 +1,754 @@
+#include "position_index.h"
+#include "json.h"
+#include "log.h"
+#include "move_ordering.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// File layout: header, position table sorted by key, move table, game ID table.
+// All integers are little-endian as written by the host.
+const char INDEX_MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'I', 'D', '1'};
+
+struct IndexHeader {
+    char magic[8];
+    uint64_t positionCount;
+    uint64_t moveCount;
+    uint64_t gameRefCount;
+    uint64_t gameCount;
+    uint64_t movesOffset;
+    uint64_t gamesOffset;
+    uint64_t reserved;
+};
+
+struct PositionRecord {
+    uint64_t key;
+    uint32_t count;
+    uint32_t whiteWins;
+    uint32_t draws;
+    uint32_t blackWins;
+    uint64_t firstMove;         // Index into the move table
+    uint64_t firstGame;         // Index into the game ID table
+    uint32_t moveCount;
+    uint32_t gameCount;
+};
+
+struct MoveRecord {
+    uint16_t move;              // packMove
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t whiteWins;
+    uint32_t draws;
+    uint32_t blackWins;
+};
+
+// One position of one game, as written to the sorted runs
+struct RunEntry {
+    uint64_t key;
+    uint32_t game;
+    uint16_t move;              // Move played from the position, 0 at the end of the game
+    uint8_t result;             // GameResult
+    uint8_t reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 64, "index header layout");
+static_assert(sizeof(PositionRecord) == 48, "position record layout");
+static_assert(sizeof(MoveRecord) == 20, "move record layout");
+static_assert(sizeof(RunEntry) == 16, "run entry layout");
+
+enum GameResult : uint8_t { WHITE_WIN, DRAW, BLACK_WIN, UNKNOWN };
+
+const size_t GAMES_PER_BATCH = 256;
+const size_t RUN_READ_BUFFER = 4096;
+
+bool entryLess(const RunEntry& a, const RunEntry& b) {
+    return a.key != b.key ? a.key < b.key : a.game < b.game;
+}
+
+GameResult parseResult(const std::string& text) {
+    if (text == "1-0") return WHITE_WIN;
+    if (text == "0-1") return BLACK_WIN;
+    if (text == "1/2-1/2") return DRAW;
+    return UNKNOWN;
+}
+
+void addResult(GameResult result, uint32_t& whiteWins, uint32_t& draws, uint32_t& blackWins) {
+    if (result == WHITE_WIN) whiteWins++;
+    else if (result == DRAW) draws++;
+    else if (result == BLACK_WIN) blackWins++;
+}
+
+struct PgnGame {
+    uint32_t id;
+    std::string text;
+};
+
+// Replays one PGN game and appends an entry for every position it reaches, once
+// per position even if it repeats. Returns false if a move could not be read, in
+// which case nothing is appended.
+bool indexGame(const PgnGame& game, int maxPly, std::vector<RunEntry>& entries) {
+    const std::string& text = game.text;
+    std::string fen;
+    GameResult result = UNKNOWN;
+    std::vector<std::string> sanMoves;
+
+    size_t i = 0;
+    while (i < text.length()) {
+        char c = text[i];
+        if (c == '[') {
+            // Tag pair: [Name "Value"]
+            size_t end = text.find('\n', i);
+            if (end == std::string::npos) end = text.length();
+            std::string tag = text.substr(i + 1, end - i - 1);
+            size_t open = tag.find('"');
+            size_t close = tag.rfind('"');
+            if (open != std::string::npos && close > open) {
+                std::string name = tag.substr(0, tag.find(' '));
+                std::string value = tag.substr(open + 1, close - open - 1);
+                if (name == "Result") result = parseResult(value);
+                if (name == "FEN") fen = value;
+            }
+            i = end;
+        } else if (c == '{') {
+            i = text.find('}', i);
+            if (i == std::string::npos) break;
+            i++;
+        } else if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            i = text.find('\n', i);
+            if (i == std::string::npos) break;
+        } else if (c == '(') {
+            // Variations are not part of the game; they may nest and contain comments
+            int depth = 0;
+            for (; i < text.length(); i++) {
+                if (text[i] == '{') {
+                    i = text.find('}', i);
+                    if (i == std::string::npos) break;
+                } else if (text[i] == '(') {
+                    depth++;
+                } else if (text[i] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            if (i == std::string::npos) break;
+            i++;
+        } else if (std::isspace(static_cast<unsigned char>(c)) || c == ')') {
+            i++;
+        } else {
+            size_t end = i;
+            while (end < text.length() && !std::isspace(static_cast<unsigned char>(text[end])) &&
+                   !std::strchr("{}();", text[end])) {
+                end++;
+            }
+            std::string token = text.substr(i, end - i);
+            i = end;
+
+            if (token[0] == '$' || token == "*") continue;
+            if (parseResult(token) != UNKNOWN) {
+                if (result == UNKNOWN) result = parseResult(token);
+                continue;
+            }
+            // Move numbers, possibly glued to the move: "12.", "12...", "1.e4" (but not "0-0")
+            if (std::isdigit(static_cast<unsigned char>(token[0])) && token.compare(0, 3, "0-0") != 0) {
+                size_t start = token.find_first_not_of("0123456789");
+                if (start == std::string::npos) continue;
+                start = token.find_first_not_of('.', start);
+                if (start == std::string::npos) continue;
+                token = token.substr(start);
+            }
+            sanMoves.push_back(token);
+        }
+    }
+
+    ChessBoard board;
+    Color side = Color::WHITE;
+    if (!fen.empty() && !board.setFromFEN(fen, side)) return false;
+
+    size_t start = entries.size();
+    std::vector<uint64_t> seen;
+    auto record = [&](uint64_t key, uint16_t move) {
+        if (std::find(seen.begin(), seen.end(), key) != seen.end()) return;
+        seen.push_back(key);
+        entries.push_back(RunEntry{key, game.id, move, static_cast<uint8_t>(result), 0});
+    };
+
+    for (size_t ply = 0; ply < sanMoves.size(); ply++) {
+        if (maxPly > 0 && static_cast<int>(ply) >= maxPly) return true;
+        Move move = Move(Position(), Position());
+        if (!board.parseSAN(sanMoves[ply], side, move)) {
+            LOG_DEBUG("Skipping game " << game.id << ": cannot play " << sanMoves[ply] << " in " << board.getFEN(side));
+            entries.resize(start);
+            return false;
+        }
+        record(board.getHash(side), packMove(move));
+        board.movePiece(move);
+        side = opposite(side);
+    }
+    if (maxPly == 0 || static_cast<int>(sanMoves.size()) < maxPly) {
+        record(board.getHash(side), 0);
+    }
+    return true;
+}
+
+// Buffered reader over one sorted run
+class RunReader {
+public:
+    explicit RunReader(const std::string& path) : file(std::fopen(path.c_str(), "rb")), position(0), count(0) {
+        buffer.resize(RUN_READ_BUFFER);
+    }
+    ~RunReader() {
+        if (file) std::fclose(file);
+    }
+    RunReader(const RunReader&) = delete;
+    RunReader& operator=(const RunReader&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    bool next(RunEntry& entry) {
+        if (position == count) {
+            count = std::fread(buffer.data(), sizeof(RunEntry), buffer.size(), file);
+            position = 0;
+            if (count == 0) return false;
+        }
+        entry = buffer[position++];
+        return true;
+    }
+
+private:
+    FILE* file;
+    std::vector<RunEntry> buffer;
+    size_t position;
+    size_t count;
+};
+
+// Everything the parser threads share while building
+struct BuildState {
+    const IndexBuildConfig& config;
+    std::mutex mutex;
+    std::condition_variable batchAvailable;
+    std::condition_variable spaceAvailable;
+    std::deque<std::vector<PgnGame>> batches;
+    bool inputDone = false;
+    std::vector<std::string> runFiles;
+    bool writeFailed = false;
+    std::atomic<long long> gamesIndexed{0};
+    std::atomic<long long> gamesSkipped{0};
+    std::atomic<long long> entries{0};
+
+    explicit BuildState(const IndexBuildConfig& config) : config(config) {}
+};
+
+bool writeRun(BuildState& state, std::vector<RunEntry>& entries) {
+    if (entries.empty()) return true;
+    std::sort(entries.begin(), entries.end(), entryLess);
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        path = state.config.outputFile + ".run" + std::to_string(state.runFiles.size());
+        state.runFiles.push_back(path);
+    }
+    FILE* file = std::fopen(path.c_str(), "wb");
+    bool ok = file && std::fwrite(entries.data(), sizeof(RunEntry), entries.size(), file) == entries.size();
+    if (file && std::fclose(file) != 0) ok = false;
+    if (!ok) {
+        LOG_ERROR("Could not write " << path);
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.writeFailed = true;
+    }
+    entries.clear();
+    return ok;
+}
+
+void parserThread(BuildState& state) {
+    std::vector<RunEntry> entries;
+    entries.reserve(state.config.runEntries);
+
+    while (true) {
+        std::vector<PgnGame> batch;
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.batchAvailable.wait(lock, [&state] { return !state.batches.empty() || state.inputDone; });
+            if (state.batches.empty()) break;
+            batch = std::move(state.batches.front());
+            state.batches.pop_front();
+            state.spaceAvailable.notify_one();
+        }
+
+        for (const PgnGame& game : batch) {
+            size_t before = entries.size();
+            if (indexGame(game, state.config.maxPly, entries)) {
+                state.gamesIndexed++;
+            } else {
+                state.gamesSkipped++;
+            }
+            state.entries += static_cast<long long>(entries.size() - before);
+            if (entries.size() >= state.config.runEntries) writeRun(state, entries);
+        }
+    }
+    writeRun(state, entries);
+}
+
+// Splits the archives into games and hands them to the parser threads in
+// batches. Returns the number of games read.
+uint32_t readGames(BuildState& state) {
+    uint32_t nextId = 0;
+    std::vector<PgnGame> batch;
+    auto flushBatch = [&state, &batch]() {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        size_t limit = 4 * static_cast<size_t>(state.config.threads);
+        state.spaceAvailable.wait(lock, [&state, limit] { return state.batches.size() < limit; });
+        state.batches.push_back(std::move(batch));
+        batch.clear();
+        state.batchAvailable.notify_one();
+    };
+
+    for (const std::string& path : state.config.inputFiles) {
+        std::ifstream in(path);
+        if (!in) {
+            LOG_ERROR("Could not open " << path);
+            continue;
+        }
+
+        std::string text;
+        bool inMovetext = false;
+        auto finishGame = [&]() {
+            if (!inMovetext) return;
+            batch.push_back(PgnGame{nextId++, std::move(text)});
+            text.clear();
+            inMovetext = false;
+            if (batch.size() >= GAMES_PER_BATCH) flushBatch();
+        };
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            bool isTag = !line.empty() && line[0] == '[';
+            // A tag after moves starts the next game
+            if (isTag) finishGame();
+            else if (line.find_first_not_of(" \t") != std::string::npos) inMovetext = true;
+            text += line;
+            text += '\n';
+        }
+        finishGame();
+    }
+    if (!batch.empty()) flushBatch();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.inputDone = true;
+    state.batchAvailable.notify_all();
+    return nextId;
+}
+
+// Merges the sorted runs into the index file. Positions are written straight
+// after the header; moves and game IDs go to side files that are appended once
+// their offsets are known.
+bool mergeRuns(const IndexBuildConfig& config, const std::vector<std::string>& runFiles, uint32_t gameCount,
+               uint64_t& positionCount) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const std::string& path : runFiles) {
+        readers.push_back(std::make_unique<RunReader>(path));
+        if (!readers.back()->isOpen()) {
+            LOG_ERROR("Could not read " << path);
+            return false;
+        }
+    }
+
+    std::string tempPath = config.outputFile + ".tmp";
+    std::string movesPath = config.outputFile + ".moves";
+    std::string gamesPath = config.outputFile + ".games";
+    FILE* out = std::fopen(tempPath.c_str(), "wb+");
+    FILE* movesOut = std::fopen(movesPath.c_str(), "wb+");
+    FILE* gamesOut = std::fopen(gamesPath.c_str(), "wb+");
+    auto closeAll = [&]() {
+        if (out) std::fclose(out);
+        if (movesOut) std::fclose(movesOut);
+        if (gamesOut) std::fclose(gamesOut);
+        std::remove(movesPath.c_str());
+        std::remove(gamesPath.c_str());
+    };
+    if (!out || !movesOut || !gamesOut) {
+        LOG_ERROR("Could not create " << config.outputFile);
+        closeAll();
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    IndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+
+    // Smallest (key, game) first across all runs
+    typedef std::pair<RunEntry, size_t> Head;
+    auto greater = [](const Head& a, const Head& b) { return entryLess(b.first, a.first); };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+    for (size_t i = 0; i < readers.size(); i++) {
+        RunEntry entry;
+        if (readers[i]->next(entry)) heads.push(Head(entry, i));
+    }
+
+    PositionRecord position;
+    std::vector<MoveRecord> moves;
+    std::vector<uint32_t> games;
+    auto flushPosition = [&]() {
+        std::sort(moves.begin(), moves.end(), [](const MoveRecord& a, const MoveRecord& b) {
+            return a.count != b.count ? a.count > b.count : a.move < b.move;
+        });
+        position.firstMove = header.moveCount;
+        position.moveCount = static_cast<uint32_t>(moves.size());
+        position.firstGame = header.gameRefCount;
+        position.gameCount = static_cast<uint32_t>(games.size());
+        ok = ok && std::fwrite(&position, sizeof(position), 1, out) == 1;
+        ok = ok && (moves.empty() || std::fwrite(moves.data(), sizeof(MoveRecord), moves.size(), movesOut) == moves.size());
+        ok = ok && (games.empty() || std::fwrite(games.data(), sizeof(uint32_t), games.size(), gamesOut) == games.size());
+        header.positionCount++;
+        header.moveCount += moves.size();
+        header.gameRefCount += games.size();
+    };
+
+    bool havePosition = false;
+    while (!heads.empty() && ok) {
+        Head head = heads.top();
+        heads.pop();
+        const RunEntry& entry = head.first;
+
+        if (!havePosition || entry.key != position.key) {
+            if (havePosition) flushPosition();
+            std::memset(&position, 0, sizeof(position));
+            position.key = entry.key;
+            moves.clear();
+            games.clear();
+            havePosition = true;
+        }
+
+        GameResult result = static_cast<GameResult>(entry.result);
+        position.count++;
+        addResult(result, position.whiteWins, position.draws, position.blackWins);
+        if (games.size() < config.maxGamesPerPosition) games.push_back(entry.game);
+        if (entry.move) {
+            auto it = std::find_if(moves.begin(), moves.end(), [&entry](const MoveRecord& m) {
+                return m.move == entry.move;
+            });
+            if (it == moves.end()) {
+                MoveRecord record;
+                std::memset(&record, 0, sizeof(record));
+                record.move = entry.move;
+                moves.push_back(record);
+                it = moves.end() - 1;
+            }
+            it->count++;
+            addResult(result, it->whiteWins, it->draws, it->blackWins);
+        }
+
+        RunEntry next;
+        if (readers[head.second]->next(next)) heads.push(Head(next, head.second));
+    }
+    if (havePosition && ok) flushPosition();
+
+    // Append the side tables and fill in the header
+    auto append = [&out](FILE* from) {
+        std::rewind(from);
+        char buffer[1 << 16];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), from)) > 0) {
+            if (std::fwrite(buffer, 1, n, out) != n) return false;
+        }
+        return true;
+    };
+    header.gameCount = gameCount;
+    header.movesOffset = sizeof(IndexHeader) + header.positionCount * sizeof(PositionRecord);
+    header.gamesOffset = header.movesOffset + header.moveCount * sizeof(MoveRecord);
+    ok = ok && append(movesOut) && append(gamesOut);
+    ok = ok && std::fseek(out, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = std::fflush(out) == 0 && ok;
+    closeAll();
+
+    if (ok) {
+        std::remove(config.outputFile.c_str());
+        ok = std::rename(tempPath.c_str(), config.outputFile.c_str()) == 0;
+    }
+    if (!ok) {
+        LOG_ERROR("Could not write " << config.outputFile);
+        std::remove(tempPath.c_str());
+    }
+    positionCount = header.positionCount;
+    return ok;
+}
+
+} // namespace
+
+bool buildPositionIndex(const IndexBuildConfig& config) {
+    auto start = std::chrono::steady_clock::now();
+    IndexBuildConfig settings = config;
+    if (settings.threads <= 0) settings.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (settings.runEntries == 0) settings.runEntries = 1;
+
+    BuildState state(settings);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.threads; i++) {
+        threads.emplace_back(parserThread, std::ref(state));
+    }
+    uint32_t gameCount = readGames(state);
+    for (auto& thread : threads) thread.join();
+
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Parsed " << state.gamesIndexed << " games (" << state.gamesSkipped << " skipped) in " << parseSeconds
+             << " s, " << state.entries << " positions in " << state.runFiles.size() << " runs");
+
+    uint64_t positionCount = 0;
+    bool ok = !state.writeFailed && mergeRuns(settings, state.runFiles, gameCount, positionCount);
+    for (const std::string& path : state.runFiles) std::remove(path.c_str());
+
+    if (ok) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Wrote " << positionCount << " distinct positions to " << settings.outputFile << " in "
+                 << seconds << " s");
+    }
+    return ok;
+}
+
+PositionIndex::PositionIndex()
+    : data(nullptr), size(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{}
+
+PositionIndex::~PositionIndex() {
+    close();
+}
+
+bool PositionIndex::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(IndexHeader))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(IndexHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+    size = static_cast<size_t>(info.st_size);
+#endif
+    data = static_cast<const unsigned char*>(view);
+
+    // Reject files that are not indexes or were cut short
+    const IndexHeader* header = reinterpret_cast<const IndexHeader*>(data);
+    bool valid = std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                 header->movesOffset == sizeof(IndexHeader) + header->positionCount * sizeof(PositionRecord) &&
+                 header->gamesOffset == header->movesOffset + header->moveCount * sizeof(MoveRecord) &&
+                 header->gamesOffset + header->gameRefCount * sizeof(uint32_t) == size;
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void PositionIndex::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = fileHandle = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool PositionIndex::lookup(uint64_t key, PositionStats& stats) const {
+    if (!data) return false;
+    const IndexHeader* header = reinterpret_cast<const IndexHeader*>(data);
+    const PositionRecord* begin = reinterpret_cast<const PositionRecord*>(data + sizeof(IndexHeader));
+    const PositionRecord* end = begin + header->positionCount;
+    const PositionRecord* found = std::lower_bound(begin, end, key, [](const PositionRecord& record, uint64_t k) {
+        return record.key < k;
+    });
+    if (found == end || found->key != key) return false;
+
+    stats.count = found->count;
+    stats.whiteWins = found->whiteWins;
+    stats.draws = found->draws;
+    stats.blackWins = found->blackWins;
+
+    const MoveRecord* moves = reinterpret_cast<const MoveRecord*>(data + header->movesOffset) + found->firstMove;
+    stats.moves.clear();
+    for (uint32_t i = 0; i < found->moveCount; i++) {
+        MoveStats move;
+        move.move = unpackMove(moves[i].move);
+        move.count = moves[i].count;
+        move.whiteWins = moves[i].whiteWins;
+        move.draws = moves[i].draws;
+        move.blackWins = moves[i].blackWins;
+        stats.moves.push_back(move);
+    }
+
+    const uint32_t* games = reinterpret_cast<const uint32_t*>(data + header->gamesOffset) + found->firstGame;
+    stats.games.assign(games, games + found->gameCount);
+    return true;
+}
+
+uint64_t PositionIndex::positionCount() const {
+    return data ? reinterpret_cast<const IndexHeader*>(data)->positionCount : 0;
+}
+
+uint64_t PositionIndex::gameCount() const {
+    return data ? reinterpret_cast<const IndexHeader*>(data)->gameCount : 0;
+}
+
+std::string PositionIndex::defaultPath() {
+    const char* path = std::getenv("CHESS_POSITION_INDEX");
+    return path ? path : "positions.idx";
+}
+
+int runIndexCommand(int argc, char* argv[]) {
+    std::string action = (argc > 2) ? argv[2] : "";
+    auto usage = []() {
+        std::cerr << "Usage: chess index build [--output FILE] [--threads N] [--max-ply N] [--max-games N]\n"
+                  << "                         [--run-size N] FILE.pgn...\n"
+                  << "       chess index query [--index FILE] [--fen FEN]\n"
+                  << "Without --fen, query reads positions from standard input, one FEN per line.\n";
+        return 1;
+    };
+
+    if (action == "build") {
+        IndexBuildConfig config;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--output" && hasValue) {
+                config.outputFile = argv[++i];
+            } else if (arg == "--threads" && hasValue) {
+                config.threads = std::atoi(argv[++i]);
+            } else if (arg == "--max-ply" && hasValue) {
+                config.maxPly = std::atoi(argv[++i]);
+            } else if (arg == "--max-games" && hasValue) {
+                config.maxGamesPerPosition = static_cast<uint32_t>(std::atol(argv[++i]));
+            } else if (arg == "--run-size" && hasValue) {
+                config.runEntries = static_cast<size_t>(std::atoll(argv[++i]));
+            } else if (arg.compare(0, 2, "--") == 0) {
+                std::cerr << "Unknown index option: " << arg << "\n";
+                return usage();
+            } else {
+                config.inputFiles.push_back(arg);
+            }
+        }
+        if (config.inputFiles.empty()) return usage();
+        return buildPositionIndex(config) ? 0 : 1;
+    }
+
+    if (action != "query") return usage();
+
+    std::string indexPath = PositionIndex::defaultPath();
+    std::string fen;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--index" && hasValue) {
+            indexPath = argv[++i];
+        } else if (arg == "--fen" && hasValue) {
+            fen = argv[++i];
+        } else {
+            std::cerr << "Unknown index option: " << arg << "\n";
+            return usage();
+        }
+    }
+
+    PositionIndex index;
+    if (!index.open(indexPath)) {
+        std::cerr << "Could not open position index " << indexPath << "\n";
+        return 1;
+    }
+
+    // One JSON line per position, with the lookup time in microseconds
+    auto query = [&index](const std::string& fen) {
+        ChessBoard board;
+        Color side;
+        if (!board.setFromFEN(fen, side)) {
+            std::cout << "{\"fen\":" << jsonString(fen) << ",\"error\":\"invalid FEN\"}" << std::endl;
+            return;
+        }
+        PositionStats stats;
+        auto start = std::chrono::steady_clock::now();
+        index.lookup(board, side, stats);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::ostringstream json;
+        json << "{\"fen\":" << jsonString(fen) << ",\"count\":" << stats.count << ",\"white\":" << stats.whiteWins
+             << ",\"draws\":" << stats.draws << ",\"black\":" << stats.blackWins << ",\"moves\":[";
+        for (size_t i = 0; i < stats.moves.size(); i++) {
+            const MoveStats& move = stats.moves[i];
+            json << (i ? "," : "") << "{\"uci\":" << jsonString(board.getUCI(move.move))
+                 << ",\"san\":" << jsonString(board.getSAN(move.move)) << ",\"count\":" << move.count
+                 << ",\"white\":" << move.whiteWins << ",\"draws\":" << move.draws
+                 << ",\"black\":" << move.blackWins << "}";
+        }
+        json << "],\"games\":[";
+        for (size_t i = 0; i < stats.games.size(); i++) {
+            json << (i ? "," : "") << stats.games[i];
+        }
+        std::cout << json.str() << "],\"micros\":" << micros << "}" << std::endl;
+    };
+
+    if (!fen.empty()) {
+        query(fen);
+        return 0;
+    }
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        query(line);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+#ifndef POSITION_INDEX_H
+#define POSITION_INDEX_H
+
+#include "chess.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How often a move was played from a position, and how those games ended
+struct MoveStats {
+    Move move = Move(Position(), Position());
+    uint32_t count = 0;
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+};
+
+struct PositionStats {
+    uint32_t count = 0;                 // Games that reached the position
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+    std::vector<MoveStats> moves;       // Most played first
+    std::vector<uint32_t> games;        // Game IDs, ascending; at most maxGamesPerPosition of them
+};
+
+struct IndexBuildConfig {
+    std::vector<std::string> inputFiles;    // PGN archives, read in order
+    std::string outputFile = "positions.idx";
+    int threads = 0;                        // Parser threads; 0 uses every core
+    int maxPly = 0;                         // Only index the first maxPly plies of a game; 0 indexes all
+    size_t runEntries = 1 << 22;            // Entries a thread sorts in memory before writing a run
+    uint32_t maxGamesPerPosition = 256;     // Game IDs kept per position; counts are always exact
+};
+
+// Builds an index of every position in the archives. Game IDs number the
+// games in input order from 0. Parser threads turn games into (position,
+// game, move, result) entries, sort them in memory and write them out as
+// sorted runs; the runs are then merged into the index file in one pass, so
+// archives much larger than memory can be indexed. Progress is logged at info level.
+bool buildPositionIndex(const IndexBuildConfig& config);
+
+// Read-only view of an index file, memory-mapped so a lookup touches only
+// the pages it needs: a binary search over the sorted position table, then
+// the position's move and game lists.
+class PositionIndex {
+public:
+    PositionIndex();
+    ~PositionIndex();
+    PositionIndex(const PositionIndex&) = delete;
+    PositionIndex& operator=(const PositionIndex&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // Key as returned by ChessBoard::getHash; false if no indexed game reached it
+    bool lookup(uint64_t key, PositionStats& stats) const;
+    bool lookup(const ChessBoard& board, Color sideToMove, PositionStats& stats) const {
+        return lookup(board.getHash(sideToMove), stats);
+    }
+
+    uint64_t positionCount() const;
+    uint64_t gameCount() const;
+
+    // Path of the index used by games: $CHESS_POSITION_INDEX, or "positions.idx"
+    static std::string defaultPath();
+
+private:
+    const unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+// Entry point for "chess index build|query [options]"
+int runIndexCommand(int argc, char* argv[]);
+
+#endif // POSITION_INDEX_H
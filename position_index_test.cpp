@@ -0,0 +1,89 @@
+// Tests for the position index: building with one and several threads, with
+// runs small enough that several are merged, and looking positions up
+#include "tests.h"
+#include "position_index.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char* TEST_PGN =
+    "[Event \"Test\"]\n[Result \"1-0\"]\n\n1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 1-0\n\n"
+    "[Event \"Test\"]\n[Result \"0-1\"]\n\n1. e4 c5 2. Nf3 d6 0-1\n\n"
+    "[Event \"Test\"]\n[Result \"1/2-1/2\"]\n\n1. d4 d5 2. c4 e6 1/2-1/2\n\n"
+    "[Event \"Test\"]\n[Result \"1/2-1/2\"]\n\n1. e4 e5 2. Nf3 Nf6 1/2-1/2\n\n"
+    "[Event \"Test\"]\n[Result \"1-0\"]\n\n1. e4 e5 2. Bc4 Nc6 1-0\n";
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+bool buildIndex(const std::string& pgnPath, const std::string& indexPath, int threads) {
+    IndexBuildConfig config;
+    config.inputFiles.push_back(pgnPath);
+    config.outputFile = indexPath;
+    config.threads = threads;
+    config.runEntries = 4;
+    return buildPositionIndex(config);
+}
+
+bool testBuildAndLookup() {
+    const std::string pgnPath = "position_index_test.pgn";
+    const std::string onePath = "position_index_test_1.idx";
+    const std::string fourPath = "position_index_test_4.idx";
+    {
+        std::ofstream pgn(pgnPath, std::ios::binary);
+        pgn << TEST_PGN;
+    }
+
+    bool ok = check(buildIndex(pgnPath, onePath, 1), "index builds with 1 thread");
+    ok &= check(buildIndex(pgnPath, fourPath, 4), "index builds with 4 threads");
+    std::string one = readFile(onePath);
+    ok &= check(!one.empty() && one == readFile(fourPath), "index is byte-identical for 1 and 4 threads");
+
+    PositionIndex index;
+    if (check(index.open(fourPath), "index opens")) {
+        ok &= check(index.gameCount() == 5, "index counts 5 games");
+
+        ChessBoard board;
+        Color side;
+        // The board keeps the en passant square after any double push, and so does the index
+        board.setFromFEN("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", side);
+        PositionStats stats;
+        if (check(index.lookup(board, side, stats), "position after 1.e4 is found")) {
+            ok &= check(stats.count == 4 && stats.whiteWins == 2 && stats.draws == 1 && stats.blackWins == 1,
+                        "1.e4: 4 games, +2 =1 -1");
+            ok &= check(stats.games == std::vector<uint32_t>({0, 1, 3, 4}), "1.e4: games 0, 1, 3 and 4");
+            bool movesMatch = stats.moves.size() == 2 &&
+                              stats.moves[0].move == Move::fromUCI("e7e5") && stats.moves[0].count == 3 &&
+                              stats.moves[0].whiteWins == 2 && stats.moves[0].draws == 1 &&
+                              stats.moves[1].move == Move::fromUCI("c7c5") && stats.moves[1].count == 1 &&
+                              stats.moves[1].blackWins == 1;
+            ok &= check(movesMatch, "1.e4: e5 played 3 times (+2 =1), c5 once (-1)");
+        } else {
+            ok = false;
+        }
+
+        board.setFromFEN("rnbqkbnr/pppppppp/8/8/8/5N2/PPPPPPPP/RNBQKB1R b KQkq - 1 1", side);
+        ok &= check(!index.lookup(board, side, stats), "position after 1.Nf3 is not found");
+        index.close();
+    } else {
+        ok = false;
+    }
+
+    std::remove(pgnPath.c_str());
+    std::remove(onePath.c_str());
+    std::remove(fourPath.c_str());
+    return ok;
+}
+
+} // namespace
+
+bool runPositionIndexTests() {
+    return testBuildAndLookup();
+}
@@ -0,0 +1,203 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+std::atomic<Profiler::ThreadStats*> threadListHead(nullptr);
+std::string exitReportPath;
+
+struct Totals {
+    uint64_t calls = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t histogram[Profiler::HISTOGRAM_BUCKETS] = {};
+};
+
+void addRelaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    // Only the owning thread writes, so a plain load/store pair is enough
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+Totals collect(ProfilePoint point) {
+    Totals totals;
+    for (auto* thread = threadListHead.load(); thread; thread = thread->next) {
+        const Profiler::PointStats& stats = thread->points[static_cast<int>(point)];
+        totals.calls += stats.calls.load(std::memory_order_relaxed);
+        totals.totalNs += stats.totalNs.load(std::memory_order_relaxed);
+        uint64_t maxNs = stats.maxNs.load(std::memory_order_relaxed);
+        if (maxNs > totals.maxNs) totals.maxNs = maxNs;
+        for (int i = 0; i < Profiler::HISTOGRAM_BUCKETS; i++) {
+            totals.histogram[i] += stats.histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+// Upper bound of the histogram bucket containing the given quantile
+uint64_t percentileNs(const Totals& totals, double quantile) {
+    uint64_t timed = 0;
+    for (uint64_t count : totals.histogram) timed += count;
+    if (timed == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(quantile * timed);
+    uint64_t seen = 0;
+    for (int i = 0; i < Profiler::HISTOGRAM_BUCKETS; i++) {
+        seen += totals.histogram[i];
+        if (seen > target) return std::min(uint64_t(1) << (i + 1), totals.maxNs);
+    }
+    return totals.maxNs;
+}
+
+double nodesPerSecond() {
+    Totals nodes = collect(ProfilePoint::SEARCH_NODE);
+    Totals search = collect(ProfilePoint::BUILTIN_SEARCH);
+    if (search.totalNs == 0) return 0.0;
+    return nodes.calls * 1e9 / search.totalNs;
+}
+
+void writeExitReport() {
+    std::ofstream out(exitReportPath);
+    if (!out) {
+        std::cerr << "Could not write profile report to " << exitReportPath << "\n";
+        return;
+    }
+    bool json = exitReportPath.size() >= 5 &&
+                exitReportPath.compare(exitReportPath.size() - 5, 5, ".json") == 0;
+    if (json) {
+        Profiler::reportJSON(out);
+    } else {
+        Profiler::report(out);
+    }
+}
+
+} // namespace
+
+const int Profiler::HISTOGRAM_BUCKETS;
+
+Profiler::ThreadStats& Profiler::local() {
+    // Thread blocks are never freed so reports can include threads that already exited
+    thread_local ThreadStats* stats = nullptr;
+    if (!stats) {
+        stats = new ThreadStats();
+        for (auto& point : stats->points) {
+            point.calls = 0;
+            point.totalNs = 0;
+            point.maxNs = 0;
+            for (auto& bucket : point.histogram) bucket = 0;
+        }
+        stats->next = threadListHead.load();
+        while (!threadListHead.compare_exchange_weak(stats->next, stats)) {}
+    }
+    return *stats;
+}
+
+void Profiler::record(ProfilePoint point, uint64_t elapsedNs) {
+    PointStats& stats = local().points[static_cast<int>(point)];
+    addRelaxed(stats.calls, 1);
+    addRelaxed(stats.totalNs, elapsedNs);
+    if (elapsedNs > stats.maxNs.load(std::memory_order_relaxed)) {
+        stats.maxNs.store(elapsedNs, std::memory_order_relaxed);
+    }
+
+    int bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS - 1 && (elapsedNs >> (bucket + 1)) != 0) bucket++;
+    addRelaxed(stats.histogram[bucket], 1);
+}
+
+const char* Profiler::pointName(ProfilePoint point) {
+    switch (point) {
+        case ProfilePoint::GET_ALL_LEGAL_MOVES: return "getAllLegalMoves";
+        case ProfilePoint::WOULD_BE_IN_CHECK: return "wouldBeInCheck";
+        case ProfilePoint::IS_SQUARE_ATTACKED: return "isSquareAttacked";
+        case ProfilePoint::COPY_FROM: return "copyFrom";
+        case ProfilePoint::ENGINE_ROUND_TRIP: return "getBestMoveFromStockfish";
+        case ProfilePoint::UCI_SEARCH: return "UciEngine::search";
+        case ProfilePoint::BUILTIN_SEARCH: return "BuiltinEngine::search";
+        case ProfilePoint::SEARCH_NODE: return "searchNodes";
+        default: return "unknown";
+    }
+}
+
+void Profiler::report(std::ostream& out) {
+#ifndef CHESS_PROFILE
+    out << "Profiling is disabled; rebuild with -DCHESS_PROFILE to collect data.\n";
+#endif
+    out << std::left << std::setw(26) << "point" << std::right
+        << std::setw(12) << "calls" << std::setw(14) << "total ms"
+        << std::setw(12) << "mean ns" << std::setw(12) << "p50 ns"
+        << std::setw(12) << "p99 ns" << std::setw(14) << "max ns" << "\n";
+
+    for (int i = 0; i < static_cast<int>(ProfilePoint::COUNT); i++) {
+        ProfilePoint point = static_cast<ProfilePoint>(i);
+        Totals totals = collect(point);
+        if (totals.calls == 0) continue;
+
+        out << std::left << std::setw(26) << pointName(point) << std::right
+            << std::setw(12) << totals.calls;
+        if (totals.totalNs > 0) {
+            out << std::fixed << std::setprecision(3)
+                << std::setw(14) << totals.totalNs / 1e6
+                << std::setw(12) << totals.totalNs / totals.calls
+                << std::setw(12) << percentileNs(totals, 0.50)
+                << std::setw(12) << percentileNs(totals, 0.99)
+                << std::setw(14) << totals.maxNs;
+        }
+        out << "\n";
+    }
+
+    double nps = nodesPerSecond();
+    if (nps > 0) {
+        out << "Search speed: " << std::fixed << std::setprecision(0) << nps << " nodes/s\n";
+    }
+}
+
+void Profiler::reportJSON(std::ostream& out) {
+#ifdef CHESS_PROFILE
+    out << "{\"enabled\":true,\"points\":[";
+#else
+    out << "{\"enabled\":false,\"points\":[";
+#endif
+    bool first = true;
+    for (int i = 0; i < static_cast<int>(ProfilePoint::COUNT); i++) {
+        ProfilePoint point = static_cast<ProfilePoint>(i);
+        Totals totals = collect(point);
+        if (totals.calls == 0) continue;
+
+        if (!first) out << ",";
+        first = false;
+        out << "{\"name\":\"" << pointName(point) << "\""
+            << ",\"calls\":" << totals.calls
+            << ",\"total_ns\":" << totals.totalNs
+            << ",\"max_ns\":" << totals.maxNs
+            << ",\"p50_ns\":" << percentileNs(totals, 0.50)
+            << ",\"p99_ns\":" << percentileNs(totals, 0.99)
+            << ",\"histogram\":[";
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            out << (b ? "," : "") << totals.histogram[b];
+        }
+        out << "]}";
+    }
+    out << "],\"nodes_per_second\":" << static_cast<uint64_t>(nodesPerSecond()) << "}\n";
+}
+
+void Profiler::reset() {
+    for (auto* thread = threadListHead.load(); thread; thread = thread->next) {
+        for (auto& point : thread->points) {
+            point.calls = 0;
+            point.totalNs = 0;
+            point.maxNs = 0;
+            for (auto& bucket : point.histogram) bucket = 0;
+        }
+    }
+}
+
+void Profiler::dumpOnExit(const std::string& path) {
+    bool registered = !exitReportPath.empty();
+    exitReportPath = path;
+    if (!registered) std::atexit(writeExitReport);
+}
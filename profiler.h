@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hot-path instrumentation. Build with -DCHESS_PROFILE to enable it; otherwise
+// the PROFILE_* macros expand to nothing and cost nothing.
+
+enum class ProfilePoint {
+    GET_ALL_LEGAL_MOVES,
+    WOULD_BE_IN_CHECK,
+    IS_SQUARE_ATTACKED,
+    COPY_FROM,
+    ENGINE_ROUND_TRIP,
+    UCI_SEARCH,
+    BUILTIN_SEARCH,
+    SEARCH_NODE,
+    COUNT
+};
+
+class Profiler {
+public:
+    static const int HISTOGRAM_BUCKETS = 32;   // Bucket i holds latencies in [2^i, 2^(i+1)) ns
+
+    struct PointStats {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+        std::atomic<uint64_t> histogram[HISTOGRAM_BUCKETS];
+    };
+
+    // Counters owned by one thread; only that thread writes them
+    struct ThreadStats {
+        PointStats points[static_cast<int>(ProfilePoint::COUNT)];
+        ThreadStats* next;
+    };
+
+    static void count(ProfilePoint point) {
+        PointStats& stats = local().points[static_cast<int>(point)];
+        stats.calls.store(stats.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    static void record(ProfilePoint point, uint64_t elapsedNs);
+
+    static void report(std::ostream& out);
+    static void reportJSON(std::ostream& out);
+    static void reset();
+
+    // Writes a report when the program exits: JSON if the path ends in ".json", text otherwise
+    static void dumpOnExit(const std::string& path);
+
+    static const char* pointName(ProfilePoint point);
+
+private:
+    static ThreadStats& local();
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfilePoint point)
+        : point(point), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Profiler::record(point, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    ProfilePoint point;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef CHESS_PROFILE
+    #define PROFILE_SCOPE(point) ScopedTimer PROFILE_CONCAT(profileTimer_, __LINE__)(ProfilePoint::point)
+    #define PROFILE_COUNT(point) Profiler::count(ProfilePoint::point)
+#else
+    #define PROFILE_SCOPE(point) ((void)0)
+    #define PROFILE_COUNT(point) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,347 @@
+#include "engine.h"
+#include "profiler.h"
+#include <algorithm>
+
+namespace {
+
+const int pieceValues[6] = {100, 500, 320, 330, 900, 0};  // Indexed by PieceType
+
+// A capture that cannot lift the score to alpha even with this much positional
+// gain on top of the material is not worth searching in quiescence
+const int DELTA_MARGIN = 200;
+
+// Penalty for each enemy attack on the king's square and the squares around it
+const int KING_ZONE_ATTACK = 6;
+
+// Piece-square bonuses from White's point of view, row 0 is rank 1
+const int pawnTable[8][8] = {
+    {  0,  0,  0,  0,  0,  0,  0,  0},
+    {  5, 10, 10,-20,-20, 10, 10,  5},
+    {  5, -5,-10,  0,  0,-10, -5,  5},
+    {  0,  0,  0, 20, 20,  0,  0,  0},
+    {  5,  5, 10, 25, 25, 10,  5,  5},
+    { 10, 10, 20, 30, 30, 20, 10, 10},
+    { 50, 50, 50, 50, 50, 50, 50, 50},
+    {  0,  0,  0,  0,  0,  0,  0,  0}
+};
+
+const int knightTable[8][8] = {
+    {-50,-40,-30,-30,-30,-30,-40,-50},
+    {-40,-20,  0,  5,  5,  0,-20,-40},
+    {-30,  5, 10, 15, 15, 10,  5,-30},
+    {-30,  0, 15, 20, 20, 15,  0,-30},
+    {-30,  5, 15, 20, 20, 15,  5,-30},
+    {-30,  0, 10, 15, 15, 10,  0,-30},
+    {-40,-20,  0,  0,  0,  0,-20,-40},
+    {-50,-40,-30,-30,-30,-30,-40,-50}
+};
+
+const int bishopTable[8][8] = {
+    {-20,-10,-10,-10,-10,-10,-10,-20},
+    {-10,  5,  0,  0,  0,  0,  5,-10},
+    {-10, 10, 10, 10, 10, 10, 10,-10},
+    {-10,  0, 10, 10, 10, 10,  0,-10},
+    {-10,  5,  5, 10, 10,  5,  5,-10},
+    {-10,  0,  5, 10, 10,  5,  0,-10},
+    {-10,  0,  0,  0,  0,  0,  0,-10},
+    {-20,-10,-10,-10,-10,-10,-10,-20}
+};
+
+const int kingTable[8][8] = {
+    { 20, 30, 10,  0,  0, 10, 30, 20},
+    { 20, 20,  0,  0,  0,  0, 20, 20},
+    {-10,-20,-20,-20,-20,-20,-20,-10},
+    {-20,-30,-30,-40,-40,-30,-30,-20},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30}
+};
+
+// Converts a search score to the reported form: centipawns, or moves to mate
+void reportScore(int score, int& reported, bool& isMate) {
+    isMate = std::abs(score) >= BuiltinEngine::MATE_SCORE - BuiltinEngine::MAX_DEPTH;
+    reported = score;
+    if (isMate) {
+        int plies = BuiltinEngine::MATE_SCORE - std::abs(score);
+        reported = (score > 0) ? (plies + 1) / 2 : -(plies / 2);
+    }
+}
+
+int pieceSquareBonus(PieceType type, int row, int col) {
+    switch (type) {
+        case PieceType::PAWN: return pawnTable[row][col];
+        case PieceType::KNIGHT: return knightTable[row][col];
+        case PieceType::BISHOP: return bishopTable[row][col];
+        case PieceType::KING: return kingTable[row][col];
+        default: return 0;
+    }
+}
+
+} // namespace
+
+const int BuiltinEngine::MATE_SCORE;
+const int BuiltinEngine::MAX_DEPTH;
+const size_t BuiltinEngine::HASH_MOVE_ENTRIES;
+
+BuiltinEngine::BuiltinEngine() : hashMoves(HASH_MOVE_ENTRIES) {}
+
+void BuiltinEngine::newGame() {
+    ordering.clear();
+    std::fill(hashMoves.begin(), hashMoves.end(), HashMoveEntry());
+}
+
+int allocateMoveTime(const SearchLimits& limits, Color sideToMove) {
+    if (limits.movetimeMs > 0) return limits.movetimeMs;
+    if (!limits.hasClock()) return 0;
+
+    int timeLeft = (sideToMove == Color::WHITE) ? limits.wtimeMs : limits.btimeMs;
+    int increment = (sideToMove == Color::WHITE) ? limits.wincMs : limits.bincMs;
+
+    // Assume 30 more moves, spend most of the increment, and keep a safety margin
+    int budget = timeLeft / 30 + increment * 3 / 4;
+    return std::max(1, std::min(budget, timeLeft - 50));
+}
+
+int BuiltinEngine::evaluate(const ChessBoard& board, Color sideToMove) {
+    int score = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Piece* piece = board.getPiece(Position(row, col));
+            if (!piece) continue;
+
+            // Tables are written for White; mirror the rank for Black
+            int tableRow = (piece->color == Color::WHITE) ? row : 7 - row;
+            int value = pieceValues[static_cast<int>(piece->type)] +
+                        pieceSquareBonus(piece->type, tableRow, col);
+            score += (piece->color == Color::WHITE) ? value : -value;
+        }
+    }
+
+    // King safety, read off the board's attack maps
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        Position king = board.getKingPosition(color);
+        if (!king.isValid()) continue;
+        int attacks = 0;
+        for (int row = king.row - 1; row <= king.row + 1; row++) {
+            for (int col = king.col - 1; col <= king.col + 1; col++) {
+                if (Position(row, col).isValid()) attacks += board.attackCount(Position(row, col), opposite(color));
+            }
+        }
+        score += (color == Color::WHITE) ? -attacks * KING_ZONE_ATTACK : attacks * KING_ZONE_ATTACK;
+    }
+    return (sideToMove == Color::WHITE) ? score : -score;
+}
+
+bool BuiltinEngine::shouldStop() {
+    if (stopped) return true;
+    if ((nodeLimit > 0 && nodes >= nodeLimit) || (stopFlag && stopFlag->load(std::memory_order_relaxed))) {
+        stopped = true;
+    } else if (hasDeadline && (nodes & 255) == 0 && std::chrono::steady_clock::now() >= deadline) {
+        stopped = true;
+    }
+    return stopped;
+}
+
+SearchResult BuiltinEngine::search(const ChessBoard& board, Color sideToMove, const SearchLimits& limits) {
+    PROFILE_SCOPE(BUILTIN_SEARCH);
+    SearchResult result;
+    searchStart = std::chrono::steady_clock::now();
+    nodes = 0;
+    nodeLimit = limits.nodes;
+    stopFlag = limits.stop;
+    stopped = false;
+    ordering.newSearch();
+
+    int moveTime = allocateMoveTime(limits, sideToMove);
+    if (limits.deadlineMs > 0) {
+        moveTime = (moveTime > 0) ? std::min(moveTime, limits.deadlineMs) : limits.deadlineMs;
+    }
+    hasDeadline = moveTime > 0;
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(moveTime);
+
+    // Without any limit, fall back to a shallow fixed depth
+    int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_DEPTH)
+                 : (hasDeadline || nodeLimit > 0) ? MAX_DEPTH : 4;
+
+    auto rootMoves = board.getAllLegalMoves(sideToMove);
+    if (rootMoves.empty()) return result;
+    result.bestMove = board.getUCI(rootMoves.front());
+
+    // Multi-PV: line k is a full search of the root with the first k-1 best moves excluded
+    int lines = std::max(1, std::min(limits.multiPV, static_cast<int>(rootMoves.size())));
+
+    previousBestMove.clear();
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        excludedRootMoves.clear();
+        bool foundMate = false;
+        for (int line = 1; line <= lines; line++) {
+            rootBestMove.clear();
+            int score = negamax(board, sideToMove, depth, -MATE_SCORE - 1, MATE_SCORE + 1, 0, nullptr);
+
+            // A partial iteration still searched the previous best move first
+            if (line == 1 && !rootBestMove.empty()) {
+                result.bestMove = rootBestMove;
+                previousBestMove = rootBestMove;
+            }
+            if (stopped || rootBestMove.empty()) break;
+            excludedRootMoves.push_back(packMove(Move::fromUCI(rootBestMove)));
+
+            SearchInfo info;
+            info.depth = depth;
+            info.multipv = line;
+            info.hasScore = true;
+            reportScore(score, info.score, info.isMate);
+            info.nodes = nodes;
+            info.timeMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - searchStart).count());
+            info.pv = rootPV(board);
+            if (line == 1) {
+                result.depth = depth;
+                result.score = info.score;
+                result.isMate = info.isMate;
+                result.pv = info.pv;
+                foundMate = info.isMate;
+            }
+            if (infoCallback) infoCallback(info);
+        }
+        if (stopped || foundMate) break;
+    }
+
+    result.ponderMove = (result.pv.size() > 1) ? result.pv[1] : "";
+    result.nodes = nodes;
+    return result;
+}
+
+std::vector<std::string> BuiltinEngine::rootPV(const ChessBoard& board) const {
+    std::vector<std::string> pv;
+    ChessBoard position = board;
+    for (int i = 0; i < pvLength[0]; i++) {
+        Move move = unpackMove(pvTable[0][i]);
+        if (!position.isLegal(move)) break;
+        pv.push_back(position.getUCI(move));
+        position.movePiece(move);
+    }
+    return pv;
+}
+
+int BuiltinEngine::negamax(const ChessBoard& board, Color sideToMove, int depth, int alpha, int beta, int ply,
+                           const Move* previousMove) {
+    nodes++;
+    PROFILE_COUNT(SEARCH_NODE);
+    pvLength[ply] = ply;
+    if (ply > 0 && shouldStop()) return 0;
+
+    if (ply > 0 && (board.getHalfmoveClock() >= 100 || board.hasInsufficientMaterial())) {
+        return 0;
+    }
+
+    if (depth <= 0) {
+        return quiescence(board, sideToMove, alpha, beta, ply);
+    }
+
+    auto moves = board.getAllLegalMoves(sideToMove);
+    if (moves.empty()) {
+        return board.isInCheck(sideToMove) ? -MATE_SCORE + ply : 0;
+    }
+
+    // The root always starts with the previous iteration's best move
+    uint64_t key = board.getHash(sideToMove);
+    HashMoveEntry& entry = hashMoves[key & (HASH_MOVE_ENTRIES - 1)];
+    uint16_t hashMove = (entry.key == key) ? entry.move : 0;
+    if (ply == 0 && !previousBestMove.empty()) hashMove = packMove(Move::fromUCI(previousBestMove));
+
+    MovePicker picker(board, sideToMove, moves, ordering, ply, hashMove, previousMove);
+    std::vector<Move> failedQuiets;
+    uint16_t bestMove = 0;
+    int bestScore = -MATE_SCORE - 1;
+    Move move = moves.front();
+    while (picker.next(move)) {
+        if (ply == 0 && std::find(excludedRootMoves.begin(), excludedRootMoves.end(), packMove(move)) !=
+                            excludedRootMoves.end()) {
+            continue;
+        }
+
+        ChessBoard child = board;
+        child.movePiece(move);
+        int score = -negamax(child, opposite(sideToMove), depth - 1, -beta, -alpha, ply + 1, &move);
+        if (stopped) break;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = packMove(move);
+            if (ply == 0) rootBestMove = board.getUCI(move);
+        }
+        if (score > alpha) {
+            alpha = score;
+            pvTable[ply][ply] = packMove(move);
+            for (int i = ply + 1; i < pvLength[ply + 1]; i++) pvTable[ply][i] = pvTable[ply + 1][i];
+            pvLength[ply] = std::max(ply + 1, pvLength[ply + 1]);
+        }
+        if (alpha >= beta) {
+            if (picker.lastWasQuiet()) {
+                ordering.recordCutoff(sideToMove, move, depth, ply, previousMove, failedQuiets);
+            }
+            break;
+        }
+        if (picker.lastWasQuiet()) failedQuiets.push_back(move);
+    }
+
+    if (!stopped && bestMove) {
+        entry.key = key;
+        entry.move = bestMove;
+    }
+    return bestScore;
+}
+
+int BuiltinEngine::quiescence(const ChessBoard& board, Color sideToMove, int alpha, int beta, int ply) {
+    nodes++;
+    PROFILE_COUNT(SEARCH_NODE);
+    pvLength[ply] = ply;   // Captures at the horizon are not part of the reported line
+    if (shouldStop()) return 0;
+
+    bool inCheck = board.isInCheck(sideToMove);
+    auto moves = board.getAllLegalMoves(sideToMove);
+    if (moves.empty()) {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+    if (ply >= MoveOrdering::MAX_PLY - 1) {
+        return evaluate(board, sideToMove);
+    }
+
+    // Stand pat: unless in check, the side to move may decline every capture
+    int standPat = 0;
+    int bestScore = -MATE_SCORE - 1;
+    if (!inCheck) {
+        standPat = evaluate(board, sideToMove);
+        if (standPat >= beta) return standPat;
+        if (standPat > alpha) alpha = standPat;
+        bestScore = standPat;
+    }
+
+    // In check every evasion is searched; otherwise captures that lose material are skipped
+    MovePicker picker = inCheck ? MovePicker(board, sideToMove, moves, ordering, ply, 0, nullptr)
+                                : MovePicker(board, sideToMove, moves, ordering);
+    Move move = moves.front();
+    while (picker.next(move)) {
+        if (!inCheck) {
+            Piece* victim = board.getPiece(move.to);
+            int gain = victim ? pieceValues[static_cast<int>(victim->type)] : pieceValues[0];
+            if (move.promotionPiece == PieceType::QUEEN && (move.to.row == 0 || move.to.row == 7) &&
+                board.getPiece(move.from)->type == PieceType::PAWN) {
+                gain += pieceValues[static_cast<int>(PieceType::QUEEN)] - pieceValues[0];
+            }
+            if (standPat + gain + DELTA_MARGIN <= alpha) continue;
+        }
+
+        ChessBoard child = board;
+        child.movePiece(move);
+        int score = -quiescence(child, opposite(sideToMove), -beta, -alpha, ply + 1);
+        if (stopped) break;
+
+        if (score > bestScore) bestScore = score;
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    return bestScore;
+}
@@ -0,0 +1,30 @@
+// Entry point of chess_tests: runs every test group and exits with status 1 if
+// any check failed
+#include "tests.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+const char* FAKE_ENGINE_VARIABLE = "CHESS_TEST_FAKE_ENGINE";
+
+bool check(bool condition, const std::string& what) {
+    std::cout << (condition ? "PASS " : "FAIL ") << what << std::endl;
+    return condition;
+}
+
+int main(int, char* argv[]) {
+    if (std::getenv(FAKE_ENGINE_VARIABLE)) return runFakeEngine();
+#ifdef _WIN32
+    _putenv_s(FAKE_ENGINE_VARIABLE, "1");
+#else
+    setenv(FAKE_ENGINE_VARIABLE, "1", 1);
+    // As in main.cpp: a fake engine that exits early must not end the tests
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    bool ok = runBoardTests();
+    ok &= runPositionIndexTests();
+    ok &= runUciFrontendTests();
+    ok &= runUciEngineTests(argv[0]);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <string>
+
+// Set in the environment of a child started from the test binary, which then
+// acts as a scripted UCI engine instead of running the tests
+extern const char* FAKE_ENGINE_VARIABLE;
+
+// Prints PASS or FAIL with the description; returns condition
+bool check(bool condition, const std::string& what);
+
+// One group per *_test.cpp file; each returns false if any of its checks failed
+int runFakeEngine();
+bool runUciEngineTests(const std::string& self);
+bool runBoardTests();
+bool runPositionIndexTests();
+bool runUciFrontendTests();
+
+#endif // TESTS_H
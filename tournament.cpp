@@ -0,0 +1,384 @@
+#include "tournament.h"
+#include "log.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+
+namespace {
+
+double scoreToElo(double score) {
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double eloToScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+} // namespace
+
+double TournamentStats::score() const {
+    if (games() == 0) return 0.5;
+    return (wins + 0.5 * draws) / games();
+}
+
+double TournamentStats::eloDifference() const {
+    return scoreToElo(score());
+}
+
+double TournamentStats::eloErrorMargin() const {
+    int n = games();
+    if (n == 0) return 0.0;
+
+    // Per-game variance of the trinomial result
+    double s = score();
+    double variance = (wins * (1.0 - s) * (1.0 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+    double stdError = std::sqrt(variance / n);
+    return (scoreToElo(s + 1.96 * stdError) - scoreToElo(s - 1.96 * stdError)) / 2.0;
+}
+
+double TournamentStats::sprtLLR(double elo0, double elo1) const {
+    int n = games();
+    if (n == 0) return 0.0;
+
+    double s = score();
+    double variance = (wins * (1.0 - s) * (1.0 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+    if (variance <= 0.0) return 0.0;
+
+    // Normal approximation of the generalized SPRT
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return n * (s1 - s0) * (2.0 * s - s0 - s1) / (2.0 * variance);
+}
+
+Tournament::Tournament(const TournamentConfig& config)
+    : config(config), nextGame(0), stopRequested(false) {
+    if (!config.openingsFile.empty()) {
+        std::ifstream in(config.openingsFile);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            openings.push_back(line);
+        }
+        if (openings.empty()) {
+            LOG_WARN("No openings loaded from " << config.openingsFile);
+        }
+    }
+    if (openings.empty()) openings.push_back("");
+}
+
+TournamentStats Tournament::run() {
+    pgn.open(config.pgnFile, std::ios::app);
+    if (!pgn) {
+        LOG_ERROR("Could not open PGN file " << config.pgnFile);
+    }
+
+    int threadCount = std::max(1, std::min(config.concurrency, config.games));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&Tournament::worker, this);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    printReport();
+    return stats;
+}
+
+void Tournament::worker() {
+    // Each worker owns its engines, so UCI processes are never shared between games
+    std::unique_ptr<Engine> engine1 = createEngine(config.engine1);
+    std::unique_ptr<Engine> engine2 = createEngine(config.engine2);
+    if (!engine1 || !engine2) {
+        LOG_ERROR("Failed to start engines for tournament worker");
+        stopRequested = true;
+        return;
+    }
+
+    while (!stopRequested) {
+        int gameIndex = nextGame++;
+        if (gameIndex >= config.games) break;
+
+        // Every opening is played twice with colors reversed
+        const std::string& opening = openings[(gameIndex / 2) % openings.size()];
+        bool engine1White = (gameIndex % 2 == 0);
+
+        GameRecord record = engine1White ? playGame(*engine1, *engine2, opening)
+                                         : playGame(*engine2, *engine1, opening);
+        recordGame(gameIndex, record, engine1White);
+    }
+}
+
+Tournament::GameRecord Tournament::playGame(Engine& white, Engine& black, const std::string& startFEN) {
+    GameRecord record;
+    record.whiteName = white.getName();
+    record.blackName = black.getName();
+    record.startFEN = startFEN;
+
+    ChessBoard board;
+    Color side = Color::WHITE;
+    if (!startFEN.empty() && !board.setFromFEN(startFEN, side)) {
+        LOG_WARN("Invalid opening FEN: " << startFEN);
+        record.result = "1/2-1/2";
+        record.termination = "invalid opening";
+        return record;
+    }
+
+    white.newGame();
+    black.newGame();
+
+    SearchLimits limits = config.limits;
+    bool useClock = limits.hasClock();
+    std::map<std::string, int> repetitions;
+    repetitions[board.getPositionKey(side)]++;
+
+    for (int ply = 0; ; ply++) {
+        std::string sideLoses = (side == Color::WHITE) ? "0-1" : "1-0";
+
+        // Adjudication, following ChessGame::checkGameEnd plus the draw rules
+        auto legalMoves = board.getAllLegalMoves(side);
+        if (legalMoves.empty()) {
+            if (board.isInCheck(side)) {
+                record.result = sideLoses;
+                record.termination = "checkmate";
+            } else {
+                record.result = "1/2-1/2";
+                record.termination = "stalemate";
+            }
+            break;
+        }
+        if (board.getHalfmoveClock() >= 100) {
+            record.result = "1/2-1/2";
+            record.termination = "fifty-move rule";
+            break;
+        }
+        if (board.hasInsufficientMaterial()) {
+            record.result = "1/2-1/2";
+            record.termination = "insufficient material";
+            break;
+        }
+        if (repetitions[board.getPositionKey(side)] >= 3) {
+            record.result = "1/2-1/2";
+            record.termination = "threefold repetition";
+            break;
+        }
+        if (ply >= config.maxPlies) {
+            record.result = "1/2-1/2";
+            record.termination = "move limit";
+            break;
+        }
+
+        Engine& engine = (side == Color::WHITE) ? white : black;
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result = engine.search(board, side, limits);
+        int elapsedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        if (useClock) {
+            int& timeLeft = (side == Color::WHITE) ? limits.wtimeMs : limits.btimeMs;
+            int increment = (side == Color::WHITE) ? limits.wincMs : limits.bincMs;
+            timeLeft -= elapsedMs;
+            if (timeLeft <= 0) {
+                record.result = sideLoses;
+                record.termination = "time forfeit";
+                break;
+            }
+            timeLeft += increment;
+        }
+
+        Move move = Move::fromUCI(result.bestMove);
+        if (std::find(legalMoves.begin(), legalMoves.end(), move) == legalMoves.end()) {
+            record.result = sideLoses;
+            record.termination = "illegal move " + result.bestMove;
+            break;
+        }
+
+        record.sanMoves.push_back(board.getSAN(move));
+        board.movePiece(move);
+        side = opposite(side);
+        repetitions[board.getPositionKey(side)]++;
+    }
+
+    return record;
+}
+
+void Tournament::recordGame(int gameIndex, const GameRecord& record, bool engine1White) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    if (record.result == "1/2-1/2") {
+        stats.draws++;
+    } else if ((record.result == "1-0") == engine1White) {
+        stats.wins++;
+    } else {
+        stats.losses++;
+    }
+    writePGN(gameIndex + 1, record);
+
+    std::cout << "Game " << (gameIndex + 1) << ": " << record.whiteName << " vs " << record.blackName
+              << " " << record.result << " (" << record.termination << ")"
+              << "  Score " << stats.wins << "-" << stats.losses << "-" << stats.draws
+              << std::fixed << std::setprecision(2)
+              << "  Elo " << stats.eloDifference() << " +/- " << stats.eloErrorMargin()
+              << "  LLR " << stats.sprtLLR(config.elo0, config.elo1) << "\n";
+
+    if (config.stopOnSprt && sprtConcluded()) {
+        stopRequested = true;
+    }
+}
+
+void Tournament::writePGN(int round, const GameRecord& record) {
+    if (!pgn) return;
+
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    pgn << "[Event \"Engine tournament\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date << "\"]\n"
+        << "[Round \"" << round << "\"]\n"
+        << "[White \"" << record.whiteName << "\"]\n"
+        << "[Black \"" << record.blackName << "\"]\n"
+        << "[Result \"" << record.result << "\"]\n"
+        << "[Termination \"" << record.termination << "\"]\n";
+
+    ChessBoard board;
+    Color side = Color::WHITE;
+    if (!record.startFEN.empty()) {
+        board.setFromFEN(record.startFEN, side);
+        pgn << "[SetUp \"1\"]\n"
+            << "[FEN \"" << record.startFEN << "\"]\n";
+    }
+    pgn << "\n";
+
+    int moveNumber = board.getFullmoveNumber();
+    std::string line;
+    for (size_t i = 0; i < record.sanMoves.size(); i++) {
+        std::string token;
+        if (side == Color::WHITE) {
+            token = std::to_string(moveNumber) + ". ";
+        } else if (i == 0) {
+            token = std::to_string(moveNumber) + "... ";
+        }
+        token += record.sanMoves[i];
+        if (side == Color::BLACK) moveNumber++;
+        side = opposite(side);
+
+        // Keep lines under the 80 column limit recommended by the PGN standard
+        if (line.length() + token.length() + 1 > 79) {
+            pgn << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    }
+    line += (line.empty() ? "" : " ") + record.result;
+    pgn << line << "\n\n";
+    pgn.flush();
+}
+
+bool Tournament::sprtConcluded() const {
+    double llr = stats.sprtLLR(config.elo0, config.elo1);
+    double lower = std::log(config.beta / (1.0 - config.alpha));
+    double upper = std::log((1.0 - config.beta) / config.alpha);
+    return llr <= lower || llr >= upper;
+}
+
+void Tournament::printReport() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+
+    double llr = stats.sprtLLR(config.elo0, config.elo1);
+    double lower = std::log(config.beta / (1.0 - config.alpha));
+    double upper = std::log((1.0 - config.beta) / config.alpha);
+
+    std::cout << "\nTournament finished: " << config.engine1 << " vs " << config.engine2 << "\n"
+              << "Games: " << stats.games()
+              << "  Wins: " << stats.wins << "  Draws: " << stats.draws << "  Losses: " << stats.losses << "\n"
+              << std::fixed << std::setprecision(2)
+              << "Score: " << (stats.score() * 100.0) << "%\n"
+              << "Elo difference: " << stats.eloDifference() << " +/- " << stats.eloErrorMargin() << " (95%)\n"
+              << "SPRT [" << config.elo0 << ", " << config.elo1 << "]: LLR " << llr
+              << " (" << lower << ", " << upper << ") ";
+    if (llr >= upper) {
+        std::cout << "H1 accepted\n";
+    } else if (llr <= lower) {
+        std::cout << "H0 accepted\n";
+    } else {
+        std::cout << "inconclusive\n";
+    }
+#ifdef CHESS_PROFILE
+    std::cout << "\n";
+    Profiler::report(std::cout);
+#endif
+}
+
+int runTournamentCommand(int argc, char* argv[]) {
+    TournamentConfig config;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--engine1" && hasValue) {
+            config.engine1 = argv[++i];
+        } else if (arg == "--engine2" && hasValue) {
+            config.engine2 = argv[++i];
+        } else if (arg == "--games" && hasValue) {
+            config.games = std::atoi(argv[++i]);
+        } else if (arg == "--concurrency" && hasValue) {
+            config.concurrency = std::atoi(argv[++i]);
+        } else if (arg == "--openings" && hasValue) {
+            config.openingsFile = argv[++i];
+        } else if (arg == "--pgn" && hasValue) {
+            config.pgnFile = argv[++i];
+        } else if (arg == "--depth" && hasValue) {
+            config.limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            config.limits.nodes = std::atoll(argv[++i]);
+        } else if (arg == "--movetime" && hasValue) {
+            config.limits.movetimeMs = std::atoi(argv[++i]);
+        } else if (arg == "--tc" && hasValue) {
+            // Seconds with optional increment, e.g. "10+0.1"
+            std::string tc = argv[++i];
+            size_t plus = tc.find('+');
+            double base = std::atof(tc.substr(0, plus).c_str());
+            double increment = (plus != std::string::npos) ? std::atof(tc.substr(plus + 1).c_str()) : 0.0;
+            config.limits.wtimeMs = config.limits.btimeMs = static_cast<int>(base * 1000);
+            config.limits.wincMs = config.limits.bincMs = static_cast<int>(increment * 1000);
+        } else if (arg == "--max-plies" && hasValue) {
+            config.maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "--sprt" && i + 2 < argc) {
+            config.elo0 = std::atof(argv[++i]);
+            config.elo1 = std::atof(argv[++i]);
+        } else if (arg == "--no-sprt-stop") {
+            config.stopOnSprt = false;
+        } else {
+            std::cerr << "Unknown tournament option: " << arg << "\n"
+                      << "Usage: chess tournament [--engine1 builtin|PATH] [--engine2 builtin|PATH]\n"
+                      << "       [--games N] [--concurrency N] [--openings FILE] [--pgn FILE]\n"
+                      << "       [--depth N] [--nodes N] [--movetime MS] [--tc SEC+INC]\n"
+                      << "       [--max-plies N] [--sprt ELO0 ELO1] [--no-sprt-stop]\n";
+            return 1;
+        }
+    }
+
+    // A bare "go" would let UCI engines search forever
+    const SearchLimits& limits = config.limits;
+    if (limits.depth == 0 && limits.nodes == 0 && limits.movetimeMs == 0 && !limits.hasClock()) {
+        config.limits.movetimeMs = 100;
+    }
+
+    if (config.games <= 0 || config.concurrency <= 0) {
+        std::cerr << "Games and concurrency must be positive\n";
+        return 1;
+    }
+
+    Tournament tournament(config);
+    tournament.run();
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include "engine.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TournamentConfig {
+    std::string engine1 = "builtin";    // "builtin" or a path to a UCI engine
+    std::string engine2 = "builtin";
+    int games = 100;
+    int concurrency = 1;
+    std::string openingsFile;           // One FEN per line; empty means the start position
+    SearchLimits limits;                // Per move limits, or the starting clock if set
+    int maxPlies = 400;                 // Adjudicate as a draw after this many plies
+    std::string pgnFile = "tournament.pgn";
+
+    // SPRT hypotheses (Elo of engine1 relative to engine2) and error rates
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+    bool stopOnSprt = true;
+};
+
+// Win/draw/loss counts from engine1's point of view
+struct TournamentStats {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const;
+    double eloDifference() const;
+    // Half width of the 95% confidence interval, in Elo
+    double eloErrorMargin() const;
+    // Log-likelihood ratio of elo1 against elo0
+    double sprtLLR(double elo0, double elo1) const;
+};
+
+class Tournament {
+public:
+    explicit Tournament(const TournamentConfig& config);
+
+    // Plays all games (or until SPRT concludes) and prints the final report
+    TournamentStats run();
+
+private:
+    struct GameRecord {
+        std::string whiteName;
+        std::string blackName;
+        std::string startFEN;
+        std::vector<std::string> sanMoves;
+        std::string result;          // "1-0", "0-1" or "1/2-1/2"
+        std::string termination;
+    };
+
+    void worker();
+    GameRecord playGame(Engine& white, Engine& black, const std::string& startFEN);
+    void recordGame(int gameIndex, const GameRecord& record, bool engine1White);
+    void writePGN(int round, const GameRecord& record);
+    void printReport() const;
+    bool sprtConcluded() const;
+
+    TournamentConfig config;
+    std::vector<std::string> openings;
+    std::atomic<int> nextGame;
+    std::atomic<bool> stopRequested;
+    mutable std::mutex statsMutex;
+    TournamentStats stats;
+    std::ofstream pgn;
+};
+
+// Entry point for "chess tournament [options]"
+int runTournamentCommand(int argc, char* argv[]);
+
+#endif // TOURNAMENT_H
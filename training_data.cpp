@@ -0,0 +1,267 @@
+#include "training_data.h"
+#include "engine.h"
+#include "log.h"
+#include "move_ordering.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+const int MATE_RECORD_SCORE = 32000;
+const uint8_t NO_EN_PASSANT = 255;
+// How often the main thread reports progress
+const int REPORT_INTERVAL_MS = 5000;
+
+// Spreads (seed, game) over the generator's state, so neighbouring games do not
+// start from related sequences
+uint64_t gameSeed(uint64_t seed, long long game) {
+    uint64_t x = seed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(game + 1);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+int16_t recordScore(const SearchResult& result) {
+    if (result.isMate) {
+        int score = MATE_RECORD_SCORE - std::abs(result.score);
+        return static_cast<int16_t>(result.score > 0 ? score : -score);
+    }
+    return static_cast<int16_t>(std::max(-MATE_RECORD_SCORE + 1000, std::min(MATE_RECORD_SCORE - 1000, result.score)));
+}
+
+struct GeneratorState {
+    explicit GeneratorState(const TrainingDataConfig& settings) : config(settings) {}
+
+    const TrainingDataConfig& config;
+    FILE* out = nullptr;
+    std::mutex fileMutex;
+    std::atomic<long long> nextGame{0};
+    std::atomic<long long> gamesPlayed{0};
+    std::atomic<long long> positions{0};
+    std::atomic<bool> failed{false};
+
+    std::mutex doneMutex;
+    std::condition_variable allDone;
+    int threadsRunning = 0;
+};
+
+// Writes a thread's records; the only point where game threads share anything
+void flushRecords(GeneratorState& state, std::vector<TrainingRecord>& records) {
+    if (records.empty()) return;
+    std::lock_guard<std::mutex> lock(state.fileMutex);
+    if (std::fwrite(records.data(), sizeof(TrainingRecord), records.size(), state.out) != records.size()) {
+        if (!state.failed.exchange(true)) LOG_ERROR("Could not write " << state.config.outputFile);
+    }
+    records.clear();
+}
+
+// Plays one game and appends its positions to records
+void playGame(BuiltinEngine& engine, const TrainingDataConfig& config, long long game,
+              std::vector<TrainingRecord>& records) {
+    std::mt19937_64 rng(gameSeed(config.seed, game));
+    ChessBoard board;
+    Color side = Color::WHITE;
+
+    // Random opening; drawn again if it ends the game before the first search.
+    // Moves are picked with rng() % count rather than a distribution, whose
+    // output differs between standard libraries.
+    for (;;) {
+        board.setupInitialPosition();
+        side = Color::WHITE;
+        bool playable = true;
+        for (int ply = 0; ply < config.randomPlies && playable; ply++) {
+            auto moves = board.getAllLegalMoves(side);
+            if (moves.empty()) {
+                playable = false;
+            } else {
+                board.movePiece(moves[rng() % moves.size()]);
+                side = opposite(side);
+            }
+        }
+        if (playable && !board.getAllLegalMoves(side).empty()) break;
+    }
+
+    engine.newGame();
+    SearchLimits limits;
+    limits.nodes = config.nodes;
+    std::unordered_map<uint64_t, int> repetitions;
+    repetitions[board.getHash(side)]++;
+    size_t firstRecord = records.size();
+    int8_t result = 0;
+
+    // Adjudication, following Tournament::playGame
+    for (int ply = config.randomPlies; ; ply++) {
+        auto legalMoves = board.getAllLegalMoves(side);
+        if (legalMoves.empty()) {
+            if (board.isInCheck(side)) result = (side == Color::WHITE) ? -1 : 1;
+            break;
+        }
+        if (board.getHalfmoveClock() >= 100 || board.hasInsufficientMaterial() ||
+            repetitions[board.getHash(side)] >= 3 || ply >= config.maxPlies) {
+            break;
+        }
+
+        SearchResult searched = engine.search(board, side, limits);
+        if (searched.bestMove.empty()) break;
+        Move move = Move::fromUCI(searched.bestMove);
+
+        TrainingRecord record;
+        packTrainingRecord(board, side, record);
+        record.score = recordScore(searched);
+        record.move = packMove(move);
+        records.push_back(record);
+
+        board.movePiece(move);
+        side = opposite(side);
+        repetitions[board.getHash(side)]++;
+    }
+
+    for (size_t i = firstRecord; i < records.size(); i++) records[i].result = result;
+}
+
+void generatorThread(GeneratorState& state) {
+    const TrainingDataConfig& config = state.config;
+    BuiltinEngine engine;
+    std::vector<TrainingRecord> records;
+    records.reserve(config.bufferRecords + config.maxPlies);
+    auto lastFlush = std::chrono::steady_clock::now();
+
+    for (long long game = state.nextGame++; game < config.games && !state.failed; game = state.nextGame++) {
+        size_t before = records.size();
+        playGame(engine, config, game, records);
+        state.positions += static_cast<long long>(records.size() - before);
+        state.gamesPlayed++;
+
+        auto now = std::chrono::steady_clock::now();
+        if (records.size() >= config.bufferRecords || now - lastFlush >= std::chrono::milliseconds(config.flushIntervalMs)) {
+            flushRecords(state, records);
+            lastFlush = now;
+        }
+    }
+    flushRecords(state, records);
+
+    std::lock_guard<std::mutex> lock(state.doneMutex);
+    state.threadsRunning--;
+    state.allDone.notify_all();
+}
+
+} // namespace
+
+void packTrainingRecord(const ChessBoard& board, Color sideToMove, TrainingRecord& record) {
+    std::memset(&record, 0, sizeof(record));
+    int pieceCount = 0;
+    for (int square = 0; square < 64; square++) {
+        Piece* piece = board.getPiece(Position(square / 8, square % 8));
+        if (!piece) continue;
+        // At most 32 pieces are ever on the board
+        if (pieceCount == 32) break;
+
+        int code = static_cast<int>(piece->type) + 1 + (piece->color == Color::BLACK ? 8 : 0);
+        record.occupancy |= 1ULL << square;
+        record.pieces[pieceCount / 2] |= static_cast<uint8_t>(code << ((pieceCount % 2) * 4));
+        pieceCount++;
+    }
+
+    record.flags = (sideToMove == Color::BLACK) ? 1 : 0;
+    if (board.canStillCastle(Color::WHITE, true)) record.flags |= 2;
+    if (board.canStillCastle(Color::WHITE, false)) record.flags |= 4;
+    if (board.canStillCastle(Color::BLACK, true)) record.flags |= 8;
+    if (board.canStillCastle(Color::BLACK, false)) record.flags |= 16;
+
+    record.enPassant = NO_EN_PASSANT;
+    int epRow = (sideToMove == Color::WHITE) ? 5 : 2;
+    for (int col = 0; col < 8; col++) {
+        if (board.isEnPassantTarget(Position(epRow, col))) record.enPassant = static_cast<uint8_t>(epRow * 8 + col);
+    }
+    record.halfmoveClock = static_cast<uint8_t>(std::min(board.getHalfmoveClock(), 255));
+}
+
+bool generateTrainingData(const TrainingDataConfig& config) {
+    TrainingDataConfig settings = config;
+    if (settings.threads <= 0) settings.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (settings.bufferRecords == 0) settings.bufferRecords = 1;
+
+    GeneratorState state(settings);
+    state.out = std::fopen(settings.outputFile.c_str(), "wb");
+    if (!state.out) {
+        LOG_ERROR("Could not open " << settings.outputFile);
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    state.threadsRunning = settings.threads;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < settings.threads; t++) {
+        threads.emplace_back(generatorThread, std::ref(state));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state.doneMutex);
+        while (!state.allDone.wait_for(lock, std::chrono::milliseconds(REPORT_INTERVAL_MS),
+                                       [&] { return state.threadsRunning == 0; })) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            LOG_INFO("Played " << state.gamesPlayed << "/" << settings.games << " games, " << state.positions
+                     << " positions (" << static_cast<long long>(state.positions / seconds) << " positions/s)");
+        }
+    }
+    for (auto& thread : threads) thread.join();
+
+    bool ok = std::fclose(state.out) == 0 && !state.failed;
+    if (!ok) {
+        LOG_ERROR("Could not write " << settings.outputFile);
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Wrote " << state.positions << " positions from " << state.gamesPlayed << " games to "
+              << settings.outputFile << " in " << seconds << " s ("
+              << (seconds > 0 ? static_cast<long long>(state.positions / seconds) : 0) << " positions/s)\n";
+    return true;
+}
+
+int runDatagenCommand(int argc, char* argv[]) {
+    TrainingDataConfig config;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--output" && hasValue) {
+            config.outputFile = argv[++i];
+        } else if (arg == "--games" && hasValue) {
+            config.games = std::atoll(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            config.threads = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            config.nodes = std::atoll(argv[++i]);
+        } else if (arg == "--random-plies" && hasValue) {
+            config.randomPlies = std::atoi(argv[++i]);
+        } else if (arg == "--max-plies" && hasValue) {
+            config.maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--buffer" && hasValue) {
+            config.bufferRecords = static_cast<size_t>(std::atoll(argv[++i]));
+        } else {
+            std::cerr << "Unknown datagen option: " << arg << "\n"
+                      << "Usage: chess datagen [--output FILE] [--games N] [--threads N] [--nodes N]\n"
+                      << "       [--random-plies N] [--max-plies N] [--seed N] [--buffer RECORDS]\n";
+            return 1;
+        }
+    }
+    if (config.games <= 0 || config.nodes <= 0 || config.randomPlies < 0 || config.maxPlies <= 0) {
+        std::cerr << "Games, nodes and max plies must be positive\n";
+        return 1;
+    }
+
+    return generateTrainingData(config) ? 0 : 1;
+}
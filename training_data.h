@@ -0,0 +1,54 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+
+#include "chess.h"
+#include <cstdint>
+#include <string>
+
+// One searched position, as written to a training data file: 32 bytes, with
+// integers little-endian as written by the host.
+//
+// Squares are numbered a1 = 0, b1 = 1, ... h8 = 63. The pieces of the occupied
+// squares are listed in ascending square order, two per byte, low nibble first:
+// 1 pawn, 2 rook, 3 knight, 4 bishop, 5 queen, 6 king (the PieceType order
+// plus one), with 8 added for black.
+struct TrainingRecord {
+    uint64_t occupancy;         // Bit n set when square n holds a piece
+    uint8_t pieces[16];
+    int16_t score;              // Search score in centipawns for the side to move; mates are +-(32000 - moves)
+    uint16_t move;              // Best move found, in packMove encoding
+    int8_t result;              // Game result: 1 white won, 0 draw, -1 black won
+    uint8_t flags;              // Bit 0 black to move; bits 1-4 castling rights K, Q, k, q
+    uint8_t enPassant;          // En passant target square, or 255
+    uint8_t halfmoveClock;      // Saturates at 255
+};
+
+static_assert(sizeof(TrainingRecord) == 32, "training record layout");
+
+void packTrainingRecord(const ChessBoard& board, Color sideToMove, TrainingRecord& record);
+
+struct TrainingDataConfig {
+    std::string outputFile = "training.bin";
+    long long games = 1000;
+    int threads = 0;                    // Game threads; 0 uses every core
+    long long nodes = 5000;             // Node limit of every search
+    int randomPlies = 8;                // Random legal moves played before the first search
+    int maxPlies = 400;                 // Adjudicate as a draw after this many plies
+    uint64_t seed = 1;
+    size_t bufferRecords = 1 << 14;     // Records a thread collects before writing them out
+    int flushIntervalMs = 5000;         // A thread also writes out its records after this long
+};
+
+// Plays games of the built-in engine against itself and writes every searched
+// position with its score, best move and the final result of the game. Each
+// game opens with random legal moves and then uses node-limited searches, so a
+// game depends only on the seed and its number: the same seed produces the same
+// records whatever the thread count, although several threads write the games
+// out in the order they finish. Each thread collects records in its own buffer
+// and only takes the file lock to write a full buffer.
+bool generateTrainingData(const TrainingDataConfig& config);
+
+// Entry point for "chess datagen [options]"
+int runDatagenCommand(int argc, char* argv[]);
+
+#endif // TRAINING_DATA_H
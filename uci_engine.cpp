@@ -0,0 +1,409 @@
+#include "engine.h"
+#include "log.h"
+#include "profiler.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+uint64_t fnv1a(const std::string& text, uint64_t hash = 14695981039346656037ULL) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+UciEngine::UciEngine(const std::string& path) : path(path), name(path) {}
+
+UciEngine::~UciEngine() {
+    if (active) {
+        active->result.cancelled = true;
+        finishSearch();
+    }
+    process.stop();
+}
+
+bool UciEngine::start() {
+    // A binary that is not a UCI engine (or hangs on startup) must not block us forever
+    const int handshakeTimeoutMs = 10000;
+    if (!process.start(path)) return false;
+    multiPV = 1;
+    options.clear();
+
+    process.writeLine("uci");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(handshakeTimeoutMs);
+    std::string line;
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0 ||
+            process.readLine(line, static_cast<int>(remaining)) != EngineProcess::ReadResult::LINE) {
+            break;
+        }
+        if (line.compare(0, 8, "id name ") == 0) {
+            name = line.substr(8);
+        } else if (line == "uciok") {
+            // Tell the engine we may ponder, so it can adjust its time management
+            process.writeLine("setoption name Ponder value true");
+            process.writeLine("isready");
+            if (waitFor("readyok", handshakeTimeoutMs)) return true;
+            break;
+        }
+    }
+    LOG_ERROR("Engine did not complete UCI handshake: " << path);
+    process.stop();
+    return false;
+}
+
+void UciEngine::setOption(const std::string& optionName, const std::string& value) {
+    process.writeLine("setoption name " + optionName + " value " + value);
+    // MultiPV changes from search to search, and only single-line searches use the cache
+    if (optionName != "MultiPV") options[optionName] = value;
+}
+
+uint64_t UciEngine::identityKey() const {
+    uint64_t hash = fnv1a(name);
+    for (const auto& option : options) hash = fnv1a("\n" + option.first + "=" + option.second, hash);
+    return hash;
+}
+
+bool UciEngine::ping(int timeoutMs) {
+    if (active || !process.isRunning()) return false;
+    process.writeLine("isready");
+    return waitFor("readyok", timeoutMs);
+}
+
+void UciEngine::newGame() {
+    if (active) {
+        cancel();
+        while (poll(-1)) {}
+    }
+    process.writeLine("ucinewgame");
+    process.writeLine("isready");
+    waitFor("readyok");
+}
+
+bool UciEngine::waitFor(const std::string& token, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::string line;
+    while (true) {
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            waitMs = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+        if (process.readLine(line, waitMs) != EngineProcess::ReadResult::LINE) return false;
+        if (line.compare(0, token.length(), token) == 0) return true;
+    }
+}
+
+SearchResult UciEngine::search(const ChessBoard& board, Color sideToMove, const SearchLimits& limits) {
+    return searchFEN(board.getFEN(sideToMove), limits);
+}
+
+bool parseInfoLine(const std::string& line, SearchInfo& info) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token) || token != "info") return false;
+
+    while (iss >> token) {
+        if (token == "depth") {
+            iss >> info.depth;
+        } else if (token == "multipv") {
+            iss >> info.multipv;
+        } else if (token == "nodes") {
+            iss >> info.nodes;
+        } else if (token == "time") {
+            iss >> info.timeMs;
+        } else if (token == "score") {
+            std::string kind;
+            iss >> kind >> info.score;
+            info.isMate = (kind == "mate");
+            info.hasScore = true;
+        } else if (token == "pv") {
+            info.pv.clear();
+            while (iss >> token) info.pv.push_back(token);
+        } else if (token == "string") {
+            break;
+        }
+    }
+    return true;
+}
+
+SearchResult UciEngine::searchFEN(const std::string& fen, const SearchLimits& limits) {
+    PROFILE_SCOPE(UCI_SEARCH);
+    if (!process.isRunning()) return SearchResult();
+
+    std::future<SearchResult> result = requestBestMove(fen, limits, infoCallback);
+    while (poll(-1)) {}
+    return result.get();
+}
+
+std::future<SearchResult> UciEngine::requestBestMove(const std::string& fen, const SearchLimits& limits,
+                                                     InfoCallback onInfo) {
+    // A leftover search (e.g. a missed ponder) must end even if the cache answers,
+    // or the next poll would wait for a bestmove that never comes
+    if (active) {
+        cancel();
+        while (poll(-1)) {}
+    }
+
+    ChessBoard board;
+    Color sideToMove;
+    bool useCache = cache && board.setFromFEN(fen, sideToMove);
+    uint64_t key = useCache ? board.getHash(sideToMove) ^ identityKey() : 0;
+
+    // A search with only a time or node budget is answered by any reasonably deep entry.
+    // The cache holds only the best line, so multi-PV searches always go to the engine.
+    AnalysisEntry entry;
+    int minDepth = (limits.depth > 0) ? limits.depth : AnalysisCache::DEFAULT_MIN_DEPTH;
+    if (useCache && limits.multiPV <= 1 && cache->lookup(key, minDepth, entry)) {
+        SearchResult result;
+        result.bestMove = entry.bestMove;
+        result.score = entry.score;
+        result.isMate = entry.isMate;
+        result.depth = entry.depth;
+        result.pv = entry.pv;
+        if (entry.pv.size() > 1) result.ponderMove = entry.pv[1];
+
+        if (onInfo) {
+            SearchInfo info;
+            info.depth = entry.depth;
+            info.score = entry.score;
+            info.isMate = entry.isMate;
+            info.hasScore = true;
+            info.pv = entry.pv;
+            onInfo(info);
+        }
+
+        std::promise<SearchResult> promise;
+        promise.set_value(result);
+        return promise.get_future();
+    }
+
+    std::future<SearchResult> future = startSearch("position fen " + fen, limits, std::move(onInfo), false);
+    if (active) {
+        active->cacheKey = key;
+        active->cacheable = useCache;
+    }
+    return future;
+}
+
+std::future<SearchResult> UciEngine::startSearch(const std::string& position, const SearchLimits& limits,
+                                                 InfoCallback onInfo, bool ponder) {
+    // One search per engine: a leftover (e.g. a missed ponder) is cancelled first
+    if (active) {
+        cancel();
+        while (poll(-1)) {}
+    }
+
+    active = std::make_unique<ActiveSearch>();
+    active->onInfo = std::move(onInfo);
+    active->limits = limits;
+    active->ponder = ponder;
+    active->start = std::chrono::steady_clock::now();
+    std::future<SearchResult> future = active->promise.get_future();
+
+    if (!process.isRunning()) {
+        finishSearch();
+        return future;
+    }
+    int lines = std::max(1, limits.multiPV);
+    if (lines != multiPV) {
+        setOption("MultiPV", std::to_string(lines));
+        multiPV = lines;
+    }
+    process.writeLine(position);
+    process.writeLine(goCommand(limits) + (ponder ? " ponder" : ""));
+    return future;
+}
+
+bool UciEngine::poll(int timeoutMs) {
+    // Past the hard deadline we send "stop", then allow a short grace period for
+    // "bestmove" before falling back to the first move of the last reported PV
+    const int stopGraceMs = 1000;
+    auto pollStart = std::chrono::steady_clock::now();
+
+    std::string line;
+    while (active) {
+        auto now = std::chrono::steady_clock::now();
+        int waitMs = -1;
+        if (timeoutMs >= 0) {
+            int polled = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - pollStart).count());
+            waitMs = std::max(0, timeoutMs - polled);
+        }
+
+        // Wake up in time for the next deadline or grace period check
+        int untilCheck = -1;
+        if (active->stopSent) {
+            auto sinceStop = std::chrono::duration_cast<std::chrono::milliseconds>(now - active->stopTime).count();
+            untilCheck = std::max(0, stopGraceMs - static_cast<int>(sinceStop));
+        } else if (!active->ponder && active->limits.deadlineMs > 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - active->start).count();
+            untilCheck = std::max(0, active->limits.deadlineMs - static_cast<int>(elapsed));
+        }
+        if (untilCheck >= 0) waitMs = (waitMs < 0) ? untilCheck : std::min(waitMs, untilCheck);
+
+        EngineProcess::ReadResult status = process.readLine(line, waitMs);
+        if (status == EngineProcess::ReadResult::LINE) {
+            handleLine(line);
+            continue;
+        }
+        if (status == EngineProcess::ReadResult::CLOSED) {
+            LOG_WARN("Engine stopped responding: " << name);
+            process.stop();
+            active->result.bestMove = active->pv.empty() ? "" : active->pv.front();
+            finishSearch();
+            break;
+        }
+
+        now = std::chrono::steady_clock::now();
+        if (active->stopSent) {
+            if (now - active->stopTime >= std::chrono::milliseconds(stopGraceMs)) {
+                LOG_WARN("Engine ignored stop, using its last PV move: " << name);
+                process.stop();
+                active->result.bestMove = active->pv.empty() ? "" : active->pv.front();
+                finishSearch();
+                break;
+            }
+        } else if (!active->ponder && active->limits.deadlineMs > 0 &&
+                   now - active->start >= std::chrono::milliseconds(active->limits.deadlineMs)) {
+            sendStop();
+        }
+
+        if (timeoutMs >= 0 && now - pollStart >= std::chrono::milliseconds(timeoutMs)) break;
+    }
+    return active != nullptr;
+}
+
+void UciEngine::handleLine(const std::string& line) {
+    SearchInfo info;
+    if (parseInfoLine(line, info)) {
+        // Secondary lines of a multi-PV search do not change the best move
+        if (info.multipv == 1) {
+            SearchResult& result = active->result;
+            if (info.depth > 0) result.depth = info.depth;
+            if (info.nodes > 0) result.nodes = info.nodes;
+            if (info.hasScore) {
+                result.score = info.score;
+                result.isMate = info.isMate;
+            }
+            if (!info.pv.empty()) active->pv = info.pv;
+        }
+        if (active->onInfo) active->onInfo(info);
+        return;
+    }
+
+    std::istringstream iss(line);
+    std::string token;
+    iss >> token;
+    if (token == "bestmove") {
+        SearchResult& result = active->result;
+        iss >> result.bestMove;
+        if (result.bestMove == "(none)") result.bestMove.clear();
+        if (iss >> token && token == "ponder") iss >> result.ponderMove;
+        finishSearch();
+    }
+}
+
+void UciEngine::sendStop() {
+    if (!active || active->stopSent) return;
+    process.writeLine("stop");
+    active->stopSent = true;
+    active->stopTime = std::chrono::steady_clock::now();
+}
+
+void UciEngine::cancel() {
+    if (!active) return;
+    active->result.cancelled = true;
+    sendStop();
+}
+
+void UciEngine::finishSearch() {
+    // Reset first so callbacks run from the future's consumer see an idle engine
+    std::unique_ptr<ActiveSearch> finished = std::move(active);
+    SearchResult& result = finished->result;
+    result.pv = finished->pv;
+
+    if (finished->cacheable && !result.cancelled && !result.bestMove.empty() && result.depth > 0) {
+        AnalysisEntry entry;
+        entry.bestMove = result.bestMove;
+        entry.score = result.score;
+        entry.isMate = result.isMate;
+        entry.depth = result.depth;
+        entry.pv = finished->pv;
+        cache->store(finished->cacheKey, entry);
+    }
+    finished->promise.set_value(result);
+}
+
+void UciEngine::startPonder(const std::string& fen, const std::string& expectedMove, const SearchLimits& limits) {
+    if (!process.isRunning() || expectedMove.empty()) return;
+
+    ponderResult = startSearch("position fen " + fen + " moves " + expectedMove, limits, nullptr, true);
+    ponderMove = expectedMove;
+}
+
+SearchResult UciEngine::ponderHit(const SearchLimits& limits) {
+    PROFILE_SCOPE(UCI_SEARCH);
+    if (!isPondering()) return SearchResult();
+
+    // The engine keeps the work done so far and continues under its normal limits
+    active->ponder = false;
+    active->limits = limits;
+    active->start = std::chrono::steady_clock::now();
+    process.writeLine("ponderhit");
+    while (poll(-1)) {}
+    return ponderResult.get();
+}
+
+void UciEngine::stopPonder() {
+    if (!isPondering()) return;
+
+    // A cancelled ponder search still answers with a bestmove, which we discard
+    cancel();
+    while (poll(-1)) {}
+    ponderResult.get();
+}
+
+std::string UciEngine::goCommand(const SearchLimits& limits) {
+    std::ostringstream go;
+    go << "go";
+    if (limits.depth > 0) go << " depth " << limits.depth;
+    if (limits.nodes > 0) go << " nodes " << limits.nodes;
+    if (limits.movetimeMs > 0) go << " movetime " << limits.movetimeMs;
+    if (limits.hasClock()) {
+        go << " wtime " << limits.wtimeMs << " btime " << limits.btimeMs
+           << " winc " << limits.wincMs << " binc " << limits.bincMs;
+    }
+    return go.str();
+}
+
+std::unique_ptr<Engine> createEngine(const std::string& spec) {
+    if (spec == "builtin") {
+        return std::make_unique<BuiltinEngine>();
+    }
+
+    auto engine = std::make_unique<UciEngine>(spec);
+    if (!engine->start()) return nullptr;
+    return engine;
+}
+
+std::string getBestMoveFromStockfish(const std::string& fen, const std::string& stockfishPath) {
+    PROFILE_SCOPE(ENGINE_ROUND_TRIP);
+    UciEngine engine(stockfishPath);
+    if (!engine.start()) {
+        LOG_ERROR("Failed to start engine: " << stockfishPath);
+        return "";
+    }
+    engine.newGame();
+
+    SearchLimits limits;
+    limits.movetimeMs = 1000;
+    limits.deadlineMs = 5000;
+    return engine.searchFEN(fen, limits).bestMove;
+}
@@ -0,0 +1,103 @@
+// Regression tests for UciEngine. The test binary doubles as the engine under
+// test: started with CHESS_TEST_FAKE_ENGINE set, it speaks just enough UCI to
+// script the engine's side of a search.
+#include "tests.h"
+#include "analysis_cache.h"
+#include "engine.h"
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const char* AFTER_E4_FEN = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+const char* AFTER_E4_C5_FEN = "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2";
+// How long a test may wait for a search before it counts as hung
+const int HANG_TIMEOUT_MS = 5000;
+
+// After a ponder miss, a search answered from the cache must still end the
+// ponder search instead of waiting for its bestmove
+bool testPonderMissAnsweredFromCache(const std::string& self) {
+    std::string cachePath = "uci_engine_test.cache";
+    std::remove(cachePath.c_str());
+    bool ok = true;
+    {
+        AnalysisCache cache(cachePath);
+        UciEngine engine(self);
+        engine.setAnalysisCache(&cache);
+        if (!check(engine.start(), "fake engine starts")) {
+            ok = false;
+        } else {
+            SearchLimits limits;
+            limits.movetimeMs = 100;
+            // Warms the cache with b1c3; the engine itself answers a2a3 from now on
+            ok &= check(engine.searchFEN(AFTER_E4_C5_FEN, limits).bestMove == "b1c3", "first search reaches the engine");
+
+            // Black was expected to answer 1.e4 with e5 but plays c5
+            engine.startPonder(AFTER_E4_FEN, "e7e5", limits);
+            ok &= check(engine.isPondering(), "ponder search starts");
+
+            auto result = std::async(std::launch::async, [&] { return engine.searchFEN(AFTER_E4_C5_FEN, limits); });
+            if (result.wait_for(std::chrono::milliseconds(HANG_TIMEOUT_MS)) != std::future_status::ready) {
+                check(false, "search after a ponder miss returns from the cache");
+                // The search thread is stuck on the engine; nothing can clean up
+                std::_Exit(1);
+            }
+            SearchResult searched = result.get();
+            ok &= check(searched.bestMove == "b1c3", "search after a ponder miss returns from the cache");
+            ok &= check(!engine.isSearching(), "ponder search is cancelled");
+
+            // The same engine with other options must not see those entries
+            UciEngine configured(self);
+            configured.setAnalysisCache(&cache);
+            if (check(configured.start(), "second fake engine starts")) {
+                configured.setOption("Hash", "32");
+                ok &= check(configured.searchFEN(AFTER_E4_C5_FEN, limits).bestMove == "d2d4",
+                            "other options do not share cache entries");
+            } else {
+                ok = false;
+            }
+        }
+    }
+    std::remove(cachePath.c_str());
+    std::remove((cachePath + ".lock").c_str());
+    return ok;
+}
+
+} // namespace
+
+// A ponder search runs until "stop" or "ponderhit"; any other search answers at
+// once, at depth 16 so the result is cached. The first search answers b1c3 and
+// later ones a2a3, unless the Hash option was set, which makes every answer d2d4.
+int runFakeEngine() {
+    std::string line;
+    bool pondering = false;
+    bool hashSet = false;
+    int searches = 0;
+    while (std::getline(std::cin, line)) {
+        if (line == "uci") {
+            std::cout << "id name FakeEngine\nuciok" << std::endl;
+        } else if (line == "isready") {
+            std::cout << "readyok" << std::endl;
+        } else if (line.compare(0, 20, "setoption name Hash ") == 0) {
+            hashSet = true;
+        } else if (line.compare(0, 3, "go ") == 0) {
+            pondering = line.find(" ponder") != std::string::npos;
+            if (pondering) continue;
+            std::string move = hashSet ? "d2d4" : (searches++ == 0 ? "b1c3" : "a2a3");
+            std::cout << "info depth 16 score cp 30 pv " << move << "\nbestmove " << move << std::endl;
+        } else if ((line == "stop" || line == "ponderhit") && pondering) {
+            pondering = false;
+            std::cout << "bestmove g1f3" << std::endl;
+        } else if (line == "quit") {
+            break;
+        }
+    }
+    return 0;
+}
+
+bool runUciEngineTests(const std::string& self) {
+    return testPonderMissAnsweredFromCache(self);
+}
@@ -0,0 +1,220 @@
+#include "uci_frontend.h"
+#include "log.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const int MAX_MULTIPV = 64;
+const int DEFAULT_MOVE_OVERHEAD_MS = 10;
+
+std::string formatInfo(const SearchInfo& info, bool showMultiPV) {
+    std::ostringstream line;
+    line << "info depth " << info.depth;
+    if (showMultiPV) line << " multipv " << info.multipv;
+    line << " score " << (info.isMate ? "mate " : "cp ") << info.score
+         << " nodes " << info.nodes
+         << " nps " << info.nodes * 1000 / std::max(1, info.timeMs)
+         << " time " << info.timeMs;
+    if (!info.pv.empty()) {
+        line << " pv";
+        for (const std::string& move : info.pv) line << " " << move;
+    }
+    return line.str();
+}
+
+} // namespace
+
+UciFrontend::UciFrontend(std::ostream& out)
+    : out(out), sideToMove(Color::WHITE), positionBase("startpos"), multiPV(1),
+      moveOverheadMs(DEFAULT_MOVE_OVERHEAD_MS), infiniteSearch(false),
+      stopRequested(false) {
+    engine.setInfoCallback([this](const SearchInfo& info) { send(formatInfo(info, multiPV > 1)); });
+}
+
+UciFrontend::~UciFrontend() {
+    stopSearch();
+}
+
+void UciFrontend::run(std::istream& in) {
+    std::string line;
+    bool quit = false;
+    while (!quit && std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        quit = !handleCommand(line);
+    }
+    // When the input just ends, a search with limits still finishes and answers
+    if (!quit && !infiniteSearch && searcher.joinable()) searcher.join();
+    stopSearch();
+}
+
+bool UciFrontend::handleCommand(const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+    if (!(args >> command)) return true;
+
+    if (command == "uci") {
+        send("id name Chess_Game");
+        send("id author Chess_Game developers");
+        send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTIPV));
+        send("option name Move Overhead type spin default " + std::to_string(DEFAULT_MOVE_OVERHEAD_MS) +
+             " min 0 max 5000");
+        send("option name Clear Hash type button");
+        send("uciok");
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "stop") {
+        stopSearch();
+    } else if (command == "go") {
+        stopSearch();
+        startSearch(args);
+    } else if (command == "position") {
+        stopSearch();
+        setPosition(args);
+    } else if (command == "ucinewgame") {
+        stopSearch();
+        engine.newGame();
+    } else if (command == "setoption") {
+        stopSearch();
+        setOption(args);
+    } else if (command == "quit") {
+        stopSearch();
+        return false;
+    } else if (command != "debug" && command != "register" && command != "ponderhit") {
+        LOG_WARN("Unknown UCI command: " << line);
+    }
+    return true;
+}
+
+void UciFrontend::setPosition(std::istringstream& args) {
+    std::string token;
+    std::string base;
+    args >> token;
+    if (token == "startpos") {
+        base = token;
+        args >> token;
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") base += (base.empty() ? "" : " ") + token;
+    } else {
+        LOG_WARN("Invalid position command: " << token);
+        return;
+    }
+
+    std::vector<std::string> moves;
+    while (args >> token) moves.push_back(token);
+
+    // A GUI resends the whole game each move; only the moves not yet played are new
+    bool extends = base == positionBase && moves.size() >= playedMoves.size() &&
+                   std::equal(playedMoves.begin(), playedMoves.end(), moves.begin());
+    if (!extends) {
+        playedMoves.clear();
+        positionBase = base;
+        if (base == "startpos") {
+            board.setupInitialPosition();
+            sideToMove = Color::WHITE;
+        } else if (!board.setFromFEN(base, sideToMove)) {
+            LOG_WARN("Invalid FEN: " << base);
+            board.setupInitialPosition();
+            sideToMove = Color::WHITE;
+            positionBase = "startpos";
+            return;
+        }
+    }
+
+    for (size_t i = playedMoves.size(); i < moves.size(); i++) {
+        Move move = (moves[i].length() >= 4) ? Move::fromUCI(moves[i]) : Move(Position(-1, -1), Position(-1, -1));
+        Piece* piece = board.getPiece(move.from);
+        if (!piece || piece->color != sideToMove || !board.isLegal(move)) {
+            LOG_WARN("Illegal move in position command: " << moves[i]);
+            break;
+        }
+        board.movePiece(move);
+        sideToMove = opposite(sideToMove);
+        playedMoves.push_back(moves[i]);
+    }
+}
+
+void UciFrontend::startSearch(std::istringstream& args) {
+    SearchLimits limits;
+    bool infinite = false;
+    std::string token;
+    while (args >> token) {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "movetime") args >> limits.movetimeMs;
+        else if (token == "wtime") args >> limits.wtimeMs;
+        else if (token == "btime") args >> limits.btimeMs;
+        else if (token == "winc") args >> limits.wincMs;
+        else if (token == "binc") args >> limits.bincMs;
+        else if (token == "infinite") infinite = true;
+    }
+
+    // Leave time for the bestmove to reach the GUI
+    if (limits.movetimeMs > 0) limits.movetimeMs = std::max(1, limits.movetimeMs - moveOverheadMs);
+    if (limits.hasClock()) {
+        limits.wtimeMs = std::max(1, limits.wtimeMs - moveOverheadMs);
+        limits.btimeMs = std::max(1, limits.btimeMs - moveOverheadMs);
+    }
+    // Without any limit, search until "stop"
+    if (limits.depth <= 0 && limits.nodes <= 0 && limits.movetimeMs <= 0 && !limits.hasClock()) infinite = true;
+    if (infinite) limits.depth = BuiltinEngine::MAX_DEPTH;
+    infiniteSearch = infinite;
+
+    limits.multiPV = multiPV;
+    limits.stop = &stopRequested;
+    stopRequested = false;
+    searcher = std::thread(&UciFrontend::searchThread, this, limits, infinite);
+}
+
+void UciFrontend::searchThread(SearchLimits limits, bool infinite) {
+    SearchResult result = engine.search(board, sideToMove, limits);
+
+    // An infinite search may not answer before "stop", even if it finished early
+    if (infinite) {
+        std::unique_lock<std::mutex> lock(stopMutex);
+        stopChanged.wait(lock, [this] { return stopRequested.load(); });
+    }
+
+    std::string line = "bestmove " + (result.bestMove.empty() ? std::string("0000") : result.bestMove);
+    if (!result.ponderMove.empty()) line += " ponder " + result.ponderMove;
+    send(line);
+}
+
+void UciFrontend::stopSearch() {
+    if (!searcher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    stopChanged.notify_all();
+    searcher.join();
+}
+
+void UciFrontend::setOption(std::istringstream& args) {
+    // "setoption name <name> [value <value>]"; names may contain spaces
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    while (args >> token) value += (value.empty() ? "" : " ") + token;
+
+    if (name == "MultiPV") {
+        multiPV = std::max(1, std::min(MAX_MULTIPV, std::atoi(value.c_str())));
+    } else if (name == "Move Overhead") {
+        moveOverheadMs = std::max(0, std::atoi(value.c_str()));
+    } else if (name == "Clear Hash") {
+        engine.newGame();
+    } else {
+        LOG_WARN("Unknown UCI option: " << name);
+    }
+}
+
+void UciFrontend::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    out << line << std::endl;
+}
+
+int runUciCommand(int, char*[]) {
+    UciFrontend frontend(std::cout);
+    frontend.run(std::cin);
+    return 0;
+}
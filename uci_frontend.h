@@ -0,0 +1,65 @@
+#ifndef UCI_FRONTEND_H
+#define UCI_FRONTEND_H
+
+#include "engine.h"
+#include <atomic>
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Serves the built-in engine over the UCI protocol, so GUIs and tournament
+// managers can drive it. Searches run on their own thread while commands keep
+// being read, so "stop" and "isready" are answered at once. The position is
+// kept between commands: a "position" command whose move list extends the
+// previous one only plays the new moves.
+class UciFrontend {
+public:
+    explicit UciFrontend(std::ostream& out);
+    ~UciFrontend();
+    UciFrontend(const UciFrontend&) = delete;
+    UciFrontend& operator=(const UciFrontend&) = delete;
+
+    // Reads commands until "quit" or the end of input
+    void run(std::istream& in);
+    // Returns false once the command was "quit"
+    bool handleCommand(const std::string& line);
+    // FEN of the position the next "go" searches
+    std::string positionFEN() const { return board.getFEN(sideToMove); }
+
+private:
+    void setPosition(std::istringstream& args);
+    void startSearch(std::istringstream& args);
+    void setOption(std::istringstream& args);
+    // Stops the running search, if any, and waits for its bestmove
+    void stopSearch();
+    void searchThread(SearchLimits limits, bool infinite);
+    void send(const std::string& line);
+
+    std::ostream& out;
+    std::mutex outputMutex;
+
+    BuiltinEngine engine;
+    ChessBoard board;
+    Color sideToMove;
+    std::string positionBase;                   // "startpos" or the FEN of the last position command
+    std::vector<std::string> playedMoves;       // Moves played from positionBase, in UCI notation
+
+    int multiPV;
+    int moveOverheadMs;                         // Taken off the clock for communication delays
+
+    std::thread searcher;
+    bool infiniteSearch;                        // The running search waits for "stop"
+    std::atomic<bool> stopRequested;
+    std::mutex stopMutex;
+    std::condition_variable stopChanged;
+};
+
+// Entry point for "chess uci"
+int runUciCommand(int argc, char* argv[]);
+
+#endif // UCI_FRONTEND_H
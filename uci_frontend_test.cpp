@@ -0,0 +1,94 @@
+// Tests for UciFrontend, driven through handleCommand with the replies written
+// to a string stream
+#include "tests.h"
+#include "uci_frontend.h"
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The position after playing moves from the start position on a fresh board
+std::string expectedFEN(const std::vector<std::string>& moves) {
+    ChessBoard board;
+    Color side = Color::WHITE;
+    for (const std::string& move : moves) {
+        board.movePiece(Move::fromUCI(move));
+        side = opposite(side);
+    }
+    return board.getFEN(side);
+}
+
+int countLines(const std::string& output, const std::string& prefix) {
+    std::istringstream lines(output);
+    std::string line;
+    int count = 0;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, prefix.length(), prefix) == 0) count++;
+    }
+    return count;
+}
+
+bool testPositionCommands() {
+    std::ostringstream out;
+    UciFrontend frontend(out);
+    bool ok = true;
+
+    frontend.handleCommand("position startpos moves e2e4");
+    ok &= check(frontend.positionFEN() == expectedFEN({"e2e4"}), "position startpos moves e2e4");
+
+    // Extends the previous list: only e7e5 is played on the stored board
+    frontend.handleCommand("position startpos moves e2e4 e7e5");
+    ok &= check(frontend.positionFEN() == expectedFEN({"e2e4", "e7e5"}), "extended move list plays the new move");
+
+    frontend.handleCommand("position startpos moves e2e4 e7e5 g1f3 b8c6");
+    ok &= check(frontend.positionFEN() == expectedFEN({"e2e4", "e7e5", "g1f3", "b8c6"}),
+                "move list extended by two moves");
+
+    // Diverges from the stored moves, so the position is rebuilt
+    frontend.handleCommand("position startpos moves d2d4 d7d5");
+    ok &= check(frontend.positionFEN() == expectedFEN({"d2d4", "d7d5"}), "diverging move list rebuilds the position");
+
+    // A shorter list is no extension either
+    frontend.handleCommand("position startpos moves d2d4");
+    ok &= check(frontend.positionFEN() == expectedFEN({"d2d4"}), "shorter move list rebuilds the position");
+
+    const std::string fen = "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1";
+    frontend.handleCommand("position fen " + fen + " moves e2e4");
+    ChessBoard board;
+    Color side;
+    board.setFromFEN(fen, side);
+    board.movePiece(Move::fromUCI("e2e4"));
+    ok &= check(frontend.positionFEN() == board.getFEN(Color::BLACK), "position fen with moves");
+    return ok;
+}
+
+bool testInfiniteSearch() {
+    std::ostringstream out;
+    bool ok = true;
+    {
+        UciFrontend frontend(out);
+        frontend.handleCommand("position startpos");
+        frontend.handleCommand("go infinite");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        frontend.handleCommand("stop");
+        ok &= check(countLines(out.str(), "bestmove ") == 1, "go infinite then stop answers exactly one bestmove");
+
+        // Nothing is searching any more, so another stop must stay silent
+        frontend.handleCommand("stop");
+        frontend.handleCommand("isready");
+    }
+    ok &= check(countLines(out.str(), "bestmove ") == 1, "a second stop does not answer again");
+    ok &= check(countLines(out.str(), "readyok") == 1, "isready answers readyok");
+    return ok;
+}
+
+} // namespace
+
+bool runUciFrontendTests() {
+    bool ok = testPositionCommands();
+    ok &= testInfiniteSearch();
+    return ok;
+}